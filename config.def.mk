@@ -12,7 +12,10 @@
 # Valid flags include:
 #   -DWITHOUT_SYSLOG        build logging.c without syslog() support
 #   -DWITHOUT_OWN_VSYSLOG   rely on system's vsyslog() in logging.c
-#   -DWITH_PTHREAD          use pthread mutexes in logging.c
+#   -DWITH_PTHREAD          use pthread mutexes and the LOG_ASYNC writer
+#                           thread in logging.c, and threads in
+#                           utf8_mem_count_par(); adds -pthread to the
+#                           compiler and linker flags
 export RLS_OPT := -DWITH_PTHREAD
 export DBG_OPT := -DWITH_PTHREAD
 
@@ -58,6 +61,10 @@ ifeq ($(BUILD_TARGET),release)
 else
   CFLAGS += $(CDFLAGS) $(DBG_OPT)
 endif
+ifneq ($(filter -DWITH_PTHREAD,$(CFLAGS)),)
+  CFLAGS  += -pthread
+  LDFLAGS += -pthread
+endif
 
 # Generic tool shorts:
 export SH      := sh
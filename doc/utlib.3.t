@@ -24,13 +24,19 @@ OVERVIEW
   logging.h       log formatted messages to files or system log
   ntime.h         clock time in nanosecond resolution
   prng.h          fast 64-bit pseudo random number generator
-  str_escape.h    C-style and string escaping; URL encoding
+  str_escape.h    C-style string escaping; URL, JSON encoding
+  str_escprof.h   table driven escaping with custom profiles
+  str_form.h      zero-copy form-urlencoded data parser
   str_icmp.h      case insensitive string compare
   str_trim.h      string trimming (whitespace and other)
   str_unescape.h  C-style string un-escaping
+  utf16.h         UTF-8 to and from UTF-16 transcoding
   utf8_decode.h   UTF-8 to UTF-32 transcoding
   utf8_encode.h   UTF-32 to UTF-8 transcoding
+  utf8_index.h    code point offset index for UTF-8 text
+  utf8_sbcs.h     Latin-1 and Windows-1252 to and from UTF-8
   utf8_locale.h   locale related utilities
+  utf8_par.h      multi-threaded UTF-8 validation
 
 
 USAGE
@@ -48,4 +54,4 @@ USAGE
 
 
 SEE ALSO
-  base16_h(3), bendian_h(3), getopts_h(3), logging_h(3), ntime_h(3), prng_h(3), str_escape_h(3), str_icmp_h(3), str_trim_h(3), str_unescape_h(3), utf8_decode_h(3), utf8_encode_h(3), utf8_locale_h(3)
+  base16_h(3), bendian_h(3), getopts_h(3), logging_h(3), ntime_h(3), prng_h(3), str_escape_h(3), str_escprof_h(3), str_form_h(3), str_icmp_h(3), str_trim_h(3), str_unescape_h(3), utf16_h(3), utf8_decode_h(3), utf8_encode_h(3), utf8_index_h(3), utf8_locale_h(3), utf8_par_h(3), utf8_sbcs_h(3)
@@ -0,0 +1,217 @@
+/*
+ * utf8_decode_ex01.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ * Validate a UTF-8 encoded file, report the offsets of malformed
+ * sequences and optionally write a repaired copy, with each malformed
+ * sequence replaced by U+FFFD. The input is memory mapped and passed
+ * block-wise through the chunked decoder and the buffered encoder.
+ *
+ * Reported offsets are those of the first byte of each malformed
+ * sequence. Like the library decoder, the repaired copy swallows the
+ * byte that reveals a sequence as malformed into the U+FFFD, even if
+ * it could start a valid sequence itself.
+ *
+ * Usage: utf8_decode_ex01 [-q] [-o outfile|-] file
+ */
+
+#if defined(_POSIX_C_SOURCE) && (_POSIX_C_SOURCE < 200112L)
+    #undef _POSIX_C_SOURCE
+#endif
+#ifndef _POSIX_C_SOURCE
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utf8_decode.h>
+#include <utf8_encode.h>
+#include <logging.h>
+#include <ntime.h>
+
+#define IBLK    (256 * 1024)        /* input bytes decoded per step */
+#define OBLK    (1024 * 1024)       /* output block size */
+
+static uint32_t cps[IBLK];
+static uint8_t obuf[OBLK];
+
+/* Write a full output block. */
+static int flush( const uint8_t *b, size_t n, void *usr )
+{
+    return n == fwrite( b, 1, n, usr ) ? 0 : -1;
+}
+
+/* Feed the block of len bytes at offset off that produced errors once
+   more byte by byte, starting from the decoder state saved before, to
+   pinpoint the errors. The decoder state is zero in between sequences,
+   cf. UTF8_DEC_CTX_INITIALIZER. */
+static void locate( utf8_dec_ctx_t ctx, const unsigned char *map, size_t off, size_t len )
+{
+    uint32_t cp;
+    size_t i, s, u, e;
+
+    /* A sequence still pending from the previous block started at the
+       last byte before this block that is not a continuation byte. */
+    s = off;
+    if ( 0 != ctx.st )
+        while ( s > 0 && 0x80 == ( map[--s] & 0xC0 ) )
+            ;
+    for ( i = off; i < off + len; ++i )
+    {
+        if ( 0 == ctx.st )
+            s = i;
+        e = ctx.err;
+        utf8_dec_update( &ctx, &cp, 1, map + i, 1, &u );
+        if ( ctx.err > e )
+            log_printf( LOG_WARNING, "malformed sequence at offset %zu\n", s );
+    }
+}
+
+static void usage( const char *name )
+{
+    fprintf( stderr, "Usage: %s [-q] [-o outfile|-] file\n", name );
+    exit( EXIT_FAILURE );
+}
+
+int main( int argc, char *argv[] )
+{
+    const char *iname = NULL, *oname = NULL;
+    const unsigned char *map = NULL;
+    FILE *ofp = NULL;
+    struct stat st;
+    utf8_dec_ctx_t dctx = UTF8_DEC_CTX_INITIALIZER, save;
+    utf8_enc_ctx_t ectx;
+    static const uint32_t rc = UTF_REPLACE_CHAR;
+    size_t off, len, n, u, ok, e;
+    int i, fd, quiet = 0, res = EXIT_SUCCESS;
+    ntime_t t;
+
+    log_open( LOG_INFO, LOG_TO_FILE, stderr, argv[0], 0, 0 );
+    for ( i = 1; i < argc; ++i )
+    {
+        if ( 0 == strcmp( argv[i], "-q" ) )
+            quiet = 1;
+        else if ( 0 == strcmp( argv[i], "-o" ) && i + 1 < argc )
+            oname = argv[++i];
+        else if ( NULL == iname )
+            iname = argv[i];
+        else
+            usage( argv[0] );
+    }
+    if ( NULL == iname )
+        usage( argv[0] );
+
+    if ( 0 > ( fd = open( iname, O_RDONLY ) ) || 0 > fstat( fd, &st ) )
+    {
+        log_printf( LOG_ERR, "open %s: %m\n", iname );
+        exit( EXIT_FAILURE );
+    }
+    if ( 0 < st.st_size )
+    {
+        map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( MAP_FAILED == map )
+        {
+            log_printf( LOG_ERR, "mmap %s: %m\n", iname );
+            exit( EXIT_FAILURE );
+        }
+        /* Advise the kernel to read ahead aggressively. */
+        posix_madvise( (void *)map, st.st_size, POSIX_MADV_SEQUENTIAL );
+    }
+    close( fd );
+
+    if ( NULL != oname )
+    {
+        ofp = 0 == strcmp( oname, "-" ) ? stdout : fopen( oname, "wb" );
+        if ( NULL == ofp )
+        {
+            log_printf( LOG_ERR, "fopen %s: %m\n", oname );
+            exit( EXIT_FAILURE );
+        }
+        utf8_enc_init( &ectx, obuf, sizeof obuf, flush, ofp );
+    }
+
+    t = nclock_get();
+    for ( off = 0; off < (size_t)st.st_size; off += len )
+    {
+        len = (size_t)st.st_size - off < IBLK ? (size_t)st.st_size - off : IBLK;
+        save = dctx;
+        /* The code point buffer holds a block's worth, so all is used. */
+        n = utf8_dec_update( &dctx, cps, IBLK, map + off, len, &u );
+        if ( dctx.err > save.err && !quiet )
+            locate( save, map, off, len );
+        if ( NULL != ofp && n != utf8_enc_update( &ectx, cps, n ) )
+            break;
+    }
+    /* Unlike utf8_mem_decode(), account for a truncated final sequence
+       by a replacement character, too. */
+    e = dctx.err;
+    ok = utf8_dec_final( &dctx, &n );
+    if ( n > e )
+    {
+        if ( !quiet )
+            log_printf( LOG_WARNING, "truncated sequence at end of input\n" );
+        if ( NULL != ofp )
+            utf8_enc_update( &ectx, &rc, 1 );
+    }
+    e = n;
+    t = nclock_get() - t;
+    log_printf( LOG_INFO, "%s: %zu bytes, %zu valid code points, %zu errors, %.1f MB/s\n",
+                iname, (size_t)st.st_size, ok, e,
+                t > 0 ? (double)st.st_size * 1e3 / t : 0.0 );
+
+    if ( NULL != ofp )
+    {
+        if ( (size_t)-1 == utf8_enc_final( &ectx, NULL ) || 0 != fflush( ofp ) )
+        {
+            log_printf( LOG_ERR, "write %s: %m\n", oname );
+            res = EXIT_FAILURE;
+        }
+        if ( stdout != ofp )
+            fclose( ofp );
+    }
+    if ( 0 != e )
+        res = EXIT_FAILURE;
+    if ( NULL != map )
+        munmap( (void *)map, st.st_size );
+    exit( res );
+}
+
+/* EOF */
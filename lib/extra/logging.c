@@ -32,7 +32,7 @@
  *
  */
 
-#define _POSIX_C_SOURCE 200809L     /* localtime_r, strerror_r */
+#define _POSIX_C_SOURCE 200809L     /* localtime_r, strerror_r, fileno */
 
 #if !defined(WITHOUT_SYSLOG) && defined(WITHOUT_OWN_VSYSLOG)
     #define _DEFAULT_SOURCE         /* vsyslog */
@@ -40,12 +40,16 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
 
 #include <unistd.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 
 #ifndef WITHOUT_SYSLOG
     #include <syslog.h>
@@ -82,10 +86,678 @@ static volatile struct {
     0
 };
 
+/* Effective cutoff priority, read without locking by log_enabled(); -1,
+   if logging is disabled altogether. Only changed with mtx held. Before
+   initialization it matches the implicit log_open() default. */
+volatile int log_level_ = LOG_DEBUG;
+
+#ifdef WITH_PTHREAD
+/* Maximum number of queued messages passed to a single writev() call;
+   this is the smallest IOV_MAX value permitted by POSIX. */
+#define ASYNC_BATCH     16
+
+/* LOG_DEFER limits: maximum number of arguments per message, including
+   '*' width and precision arguments, and maximum length of a single
+   conversion specification. */
+#define DEFER_MAXARG    8
+#define DEFER_SPECSZ    32
+
+/* Argument kinds, as determined from a conversion specification. */
+enum defer_kind {
+    A_NONE,         /* "%%" */
+    A_ERRNO,        /* "%m" */
+    A_INT,
+    A_UINT,
+    A_LONG,
+    A_ULONG,
+    A_LLONG,
+    A_ULLONG,
+    A_INTMAX,
+    A_UINTMAX,
+    A_SIZE,
+    A_PTRDIFF,
+    A_DOUBLE,
+    A_LDOUBLE,
+    A_PTR,
+    A_STR
+};
+
+union defer_arg {
+    int i;
+    unsigned u;
+    long l;
+    unsigned long ul;
+    long long ll;
+    unsigned long long ull;
+    intmax_t im;
+    uintmax_t um;
+    size_t z;
+    ptrdiff_t t;
+    double d;
+    long double ld;
+    void *p;
+    size_t s;       /* offset into str, or (size_t)-1 for a null pointer */
+};
+
+/* Message recorded for deferred formatting. String arguments are copied
+   into str, as they need not outlive the log_printf() call. */
+struct defer_rec {
+    const char *fmt;
+    const char *ident;
+    struct timeval tv;
+    int pri;
+    int eno;
+    union defer_arg arg[DEFER_MAXARG];
+    char str[LOG_ASYNC_MSGSZ / 2];
+};
+
+/* Queue for LOG_ASYNC mode: a ring of fixed size slots, filled by the
+   logging threads and drained by the writer thread. All members are
+   protected by mtx, but the mutex is never held while formatting or
+   writing messages. */
+static struct {
+    struct async_slot {
+        size_t len;         /* length of msg, 0 for a deferred record */
+        union {
+            char msg[LOG_ASYNC_MSGSZ];
+            struct defer_rec rec;
+        } u;
+    } *slot;
+    size_t qlen;
+    size_t head;
+    size_t cnt;
+    int policy;
+    int run;
+    int stopping;       /* writer is being joined, see async_stop_() */
+    int fd;
+    pthread_t tid;
+} aq;
+static pthread_cond_t aq_nonempty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t aq_notfull = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t aq_stopped = PTHREAD_COND_INITIALIZER;
+#endif /* WITH_PTHREAD */
+
+static size_t async_qlen = LOG_ASYNC_QLEN;
+static int async_policy = LOG_ASYNC_BLOCK;
+
 /*
  * Module static functions.
  */
 
+/* Buffer size for a formatted time stamp. */
+#define TSTAMP_SZ       48
+
+/* Cache of the time stamp formatted last, see log_stamp_(). */
+struct tstamp {
+    time_t sec;
+    size_t ofs;             /* offset of the microsecond digits */
+    char buf[TSTAMP_SZ];
+};
+#define TSTAMP_INITIALIZER  { (time_t)-1, 0, "" }
+
+/* Shared time stamp cache, protected by mtx. */
+static struct tstamp tsc = TSTAMP_INITIALIZER;
+
+/* Output sink for formatted log lines: either a stdio stream, or a
+   fixed size buffer, in which case excess output is truncated. */
+struct sink {
+    FILE *fp;
+    char *buf;
+    size_t sz;
+    size_t len;
+};
+
+static void sink_vprintf_( struct sink *sk, const char *fmt, va_list arglist )
+{
+    int n;
+
+    if ( sk->fp )
+        vfprintf( sk->fp, fmt, arglist );
+    else if ( sk->len + 1 < sk->sz )
+    {
+        n = vsnprintf( sk->buf + sk->len, sk->sz - sk->len, fmt, arglist );
+        if ( n > 0 )
+            sk->len = (size_t)n < sk->sz - sk->len ? sk->len + n : sk->sz - 1;
+    }
+    return;
+}
+
+static void sink_printf_( struct sink *sk, const char *fmt, ... )
+{
+    va_list arglist;
+    va_start( arglist, fmt );
+    sink_vprintf_( sk, fmt, arglist );
+    va_end( arglist );
+    return;
+}
+
+/* Write the local time tv in ISO8601 format to buf. The stamp is only
+   formatted from scratch once per second, which also picks up any change
+   of the time zone; in between just the microsecond digits are patched. */
+static void log_stamp_( struct tstamp *tsc, const struct timeval *tv, char buf[TSTAMP_SZ] )
+{
+    long us;
+    size_t i;
+
+    if ( tv->tv_sec != tsc->sec )
+    {
+        char zbuf[16];
+        struct tm ts;
+        localtime_r( &tv->tv_sec, &ts );
+        tsc->ofs = strftime( tsc->buf, sizeof tsc->buf, "%FT%T.", &ts );
+        strftime( zbuf, sizeof zbuf, "%z", &ts );
+        snprintf( tsc->buf + tsc->ofs, sizeof tsc->buf - tsc->ofs,
+                  "000000%.3s:%s", zbuf, zbuf + 3 );
+        tsc->sec = tv->tv_sec;
+    }
+    memcpy( buf, tsc->buf, sizeof tsc->buf );
+    for ( i = 6, us = (long)tv->tv_usec; i-- > 0; us /= 10 )
+        buf[tsc->ofs + i] = '0' + us % 10;
+    return;
+}
+
+/* Write the current local time to buf. Must be called with mtx held. */
+static void log_now_( char buf[TSTAMP_SZ] )
+{
+    struct timeval tv;
+    ntime_to_timeval( ntime_get(), &tv );
+    log_stamp_( &tsc, &tv, buf );
+    return;
+}
+
+/* Write a complete log line, including stamps, to a sink. */
+static void log_emit_( struct sink *sk, const char *stamp, const char *ident, int pri, const char *fmt, va_list arglist, int eno )
+{
+    /* Write time, ident, pid and priority stamps. */
+    sink_printf_( sk, "%s %s[%u]:%d: ", stamp, ident, (unsigned)getpid(), pri );
+
+    /* Process any %m sequences embedded in format string. */
+    const char *f = fmt;
+    const char *m = strstr( f, "%m" );
+    if ( m )
+    {
+        /* The POSIX strerror_r() specification does not provide
+           any means to determine the maximum length of the
+           resulting string beforehand. The GNU C Library however
+           uses a buffer of 1024 characters internally, thus we
+           simply take that as a suitable buffer size and hope
+           for the best.  N.B.: We expect the XSI-compliant
+           version of strerror_r()! */
+        char estr[1024];
+        if ( strerror_r( eno, estr, sizeof estr ) )
+            snprintf( estr, sizeof estr, "Error %d occurred", eno );
+        /* Incrementally write the formatted message, handle
+           all %m sequences in format string. */
+        do
+        {
+            /* Keep %%m, do not replace! */
+            int have_ppm;
+            have_ppm = ( m > f && m[-1] == '%' );
+            if ( have_ppm )
+                m += 2;
+            /* Write partial message using temporary format string. */
+            char xfmt[m-f+1];
+            strncpy( xfmt, f, m-f );
+            xfmt[m-f] = '\0';
+            sink_vprintf_( sk, xfmt, arglist );
+            /* Write replacement text only for a genuine %m! */
+            if ( !have_ppm )
+            {
+                sink_printf_( sk, "%s", estr );
+                m += 2;
+            }
+            /* Continue with next %m sequence, if any. */
+            f = m;
+            m = strstr( f, "%m" );
+        }
+        while ( m );
+    }
+
+    /* Write remainder of message - i.e. all of it, if no %m
+       was present in the format string to begin with. */
+    sink_vprintf_( sk, f, arglist );
+    return;
+}
+
+#ifdef WITH_PTHREAD
+/* Parse the conversion specification starting at the '%' pointed to by
+   f. Returns its length, or 0 if it is not supported for deferred
+   formatting, e.g. "%n" or positional arguments. The argument kind and
+   the number of '*' arguments are stored in *kind and *nstar, and the
+   precision in *prec: -1 if none, or -2 if taken from an argument. */
+static size_t defer_spec_( const char *f, int *kind, int *nstar, int *prec )
+{
+    static const char *const flags = "-+ #0'";
+    const char *p = f + 1;
+    int sgn, lm = 0;
+
+    *nstar = 0;
+    *prec = -1;
+    p += strspn( p, flags );
+    if ( '*' == *p )
+        ++*nstar, ++p;
+    else
+        while ( '0' <= *p && *p <= '9' )
+            ++p;
+    if ( '.' == *p )
+    {
+        ++p;
+        if ( '*' == *p )
+            ++*nstar, ++p, *prec = -2;
+        else
+            for ( *prec = 0; '0' <= *p && *p <= '9' && *prec < 100000; ++p )
+                *prec = *prec * 10 + *p - '0';
+    }
+    /* Length modifier, encoded as the kind of signed integer argument. */
+    switch ( *p )
+    {
+    case 'h':   lm = A_INT;     p += 'h' == p[1] ? 2 : 1;   break;
+    case 'l':   lm = 'l' == p[1] ? A_LLONG : A_LONG;
+                p += 'l' == p[1] ? 2 : 1;                   break;
+    case 'j':   lm = A_INTMAX;  ++p;    break;
+    case 'z':   lm = A_SIZE;    ++p;    break;
+    case 't':   lm = A_PTRDIFF; ++p;    break;
+    case 'L':   lm = A_LDOUBLE; ++p;    break;
+    default:    break;
+    }
+    sgn = 0;
+    switch ( *p )
+    {
+    case 'd': case 'i':
+        sgn = 1;
+        /* fall through */
+    case 'o': case 'u': case 'x': case 'X':
+        switch ( lm )
+        {
+        case 0: case A_INT:
+                        *kind = sgn ? A_INT : A_UINT;       break;
+        case A_LONG:    *kind = sgn ? A_LONG : A_ULONG;     break;
+        case A_LLONG:   *kind = sgn ? A_LLONG : A_ULLONG;   break;
+        case A_INTMAX:  *kind = sgn ? A_INTMAX : A_UINTMAX; break;
+        case A_SIZE:    *kind = A_SIZE;     break;
+        case A_PTRDIFF: *kind = A_PTRDIFF;  break;
+        default:        return 0;
+        }
+        break;
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A':
+        if ( 0 != lm && A_LONG != lm && A_LDOUBLE != lm )
+            return 0;
+        *kind = A_LDOUBLE == lm ? A_LDOUBLE : A_DOUBLE;
+        break;
+    case 'c':
+        if ( 0 != lm )
+            return 0;
+        *kind = A_INT;
+        break;
+    case 's':
+        if ( 0 != lm )
+            return 0;
+        *kind = A_STR;
+        break;
+    case 'p':
+        if ( 0 != lm )
+            return 0;
+        *kind = A_PTR;
+        break;
+    case '%':
+    case 'm':
+        if ( p != f + 1 )
+            return 0;
+        *kind = '%' == *p ? A_NONE : A_ERRNO;
+        break;
+    default:
+        return 0;
+    }
+    if ( p + 1 - f >= DEFER_SPECSZ )
+        return 0;
+    return p + 1 - f;
+}
+
+/* Record the arguments for the format string fmt in r. Returns the number
+   of bytes of r in use, or 0 without consuming any argument, if fmt is
+   not suited for deferred formatting, or the string arguments do not fit
+   into r. */
+static size_t defer_record_( struct defer_rec *r, const char *fmt, va_list arglist )
+{
+    const char *f, *s;
+    size_t n, l, room, na = 0, used = 0;
+    int kind, nstar, prec, i, full = 0;
+    va_list ap;
+
+    /* Check the whole format string first. */
+    for ( f = strchr( fmt, '%' ); NULL != f; f = strchr( f + n, '%' ) )
+    {
+        if ( 0 == ( n = defer_spec_( f, &kind, &nstar, &prec ) ) )
+            return 0;
+        na += nstar + ( A_INT <= kind );
+        if ( na > DEFER_MAXARG )
+            return 0;
+    }
+    /* Work on a copy, as the string arguments may still not fit. */
+    va_copy( ap, arglist );
+    na = 0;
+    for ( f = strchr( fmt, '%' ); NULL != f && !full; f = strchr( f + n, '%' ) )
+    {
+        n = defer_spec_( f, &kind, &nstar, &prec );
+        for ( i = 0; i < nstar; ++i )
+            r->arg[na++].i = va_arg( ap, int );
+        if ( -2 == prec )
+            prec = r->arg[na - 1].i >= 0 ? r->arg[na - 1].i : -1;
+        switch ( kind )
+        {
+        case A_INT:     r->arg[na++].i = va_arg( ap, int );                  break;
+        case A_UINT:    r->arg[na++].u = va_arg( ap, unsigned );             break;
+        case A_LONG:    r->arg[na++].l = va_arg( ap, long );                 break;
+        case A_ULONG:   r->arg[na++].ul = va_arg( ap, unsigned long );       break;
+        case A_LLONG:   r->arg[na++].ll = va_arg( ap, long long );           break;
+        case A_ULLONG:  r->arg[na++].ull = va_arg( ap, unsigned long long ); break;
+        case A_INTMAX:  r->arg[na++].im = va_arg( ap, intmax_t );            break;
+        case A_UINTMAX: r->arg[na++].um = va_arg( ap, uintmax_t );           break;
+        case A_SIZE:    r->arg[na++].z = va_arg( ap, size_t );               break;
+        case A_PTRDIFF: r->arg[na++].t = va_arg( ap, ptrdiff_t );            break;
+        case A_DOUBLE:  r->arg[na++].d = va_arg( ap, double );               break;
+        case A_LDOUBLE: r->arg[na++].ld = va_arg( ap, long double );         break;
+        case A_PTR:     r->arg[na++].p = va_arg( ap, void * );               break;
+        case A_STR:
+            /* Copy the string, but never read past the precision, as
+               the string need not be terminated. */
+            s = va_arg( ap, const char * );
+            room = sizeof r->str - used;
+            if ( NULL == s )
+                r->arg[na++].s = (size_t)-1;
+            else if ( room > ( l = strnlen( s, prec >= 0 && (size_t)prec < room
+                                                  ? (size_t)prec : room ) ) )
+            {
+                memcpy( r->str + used, s, l );
+                r->str[used + l] = '\0';
+                r->arg[na++].s = used;
+                used += l + 1;
+            }
+            else
+                full = 1;
+            break;
+        default:
+            break;
+        }
+    }
+    va_end( ap );
+    return full ? 0 : offsetof( struct defer_rec, str ) + used;
+}
+
+#define DEFER_PUT(v)    ( 0 == nstar ? sink_printf_( sk, spec, (v) ) \
+                        : 1 == nstar ? sink_printf_( sk, spec, w[0], (v) ) \
+                        : sink_printf_( sk, spec, w[0], w[1], (v) ) )
+
+/* Format a deferred record to a sink, by replaying every conversion
+   specification with its recorded argument. */
+static void defer_format_( struct sink *sk, const struct defer_rec *r, struct tstamp *tc )
+{
+    char stamp[TSTAMP_SZ], spec[DEFER_SPECSZ];
+    const union defer_arg *a = r->arg;
+    const char *f = r->fmt, *p;
+    size_t n;
+    int kind, nstar, prec, i, w[2];
+
+    log_stamp_( tc, &r->tv, stamp );
+    sink_printf_( sk, "%s %s[%u]:%d: ", stamp, r->ident, (unsigned)getpid(), r->pri );
+    while ( NULL != ( p = strchr( f, '%' ) ) )
+    {
+        sink_printf_( sk, "%.*s", (int)( p - f ), f );
+        n = defer_spec_( p, &kind, &nstar, &prec );
+        memcpy( spec, p, n );
+        spec[n] = '\0';
+        for ( i = 0; i < nstar; ++i )
+            w[i] = a++->i;
+        switch ( kind )
+        {
+        case A_NONE:    sink_printf_( sk, "%%" );   break;
+        case A_ERRNO:
+            {
+                /* See log_emit_() regarding the buffer size. */
+                char estr[1024];
+                if ( strerror_r( r->eno, estr, sizeof estr ) )
+                    snprintf( estr, sizeof estr, "Error %d occurred", r->eno );
+                sink_printf_( sk, "%s", estr );
+            }
+            break;
+        case A_INT:     DEFER_PUT( a->i );      break;
+        case A_UINT:    DEFER_PUT( a->u );      break;
+        case A_LONG:    DEFER_PUT( a->l );      break;
+        case A_ULONG:   DEFER_PUT( a->ul );     break;
+        case A_LLONG:   DEFER_PUT( a->ll );     break;
+        case A_ULLONG:  DEFER_PUT( a->ull );    break;
+        case A_INTMAX:  DEFER_PUT( a->im );     break;
+        case A_UINTMAX: DEFER_PUT( a->um );     break;
+        case A_SIZE:    DEFER_PUT( a->z );      break;
+        case A_PTRDIFF: DEFER_PUT( a->t );      break;
+        case A_DOUBLE:  DEFER_PUT( a->d );      break;
+        case A_LDOUBLE: DEFER_PUT( a->ld );     break;
+        case A_PTR:     DEFER_PUT( a->p );      break;
+        case A_STR:
+            DEFER_PUT( (size_t)-1 == a->s ? NULL : r->str + a->s );
+            break;
+        default:
+            break;
+        }
+        if ( A_INT <= kind )
+            ++a;
+        f = p + n;
+    }
+    sink_printf_( sk, "%s", f );
+    return;
+}
+
+/* Make sure a formatted line ends in a newline, even if truncated. */
+static size_t async_eol_( char *buf, size_t len, size_t sz )
+{
+    if ( len == sz - 1 )
+        buf[len - 1] = '\n';
+    return len;
+}
+
+/* Write a batch of messages, resuming after short writes. */
+static void async_writev_( int fd, struct iovec *iov, int n )
+{
+    ssize_t w;
+
+    while ( n > 0 )
+    {
+        w = writev( fd, iov, n );
+        if ( 0 > w )
+        {
+            if ( EINTR == errno )
+                continue;
+            return;
+        }
+        while ( n > 0 && (size_t)w >= iov->iov_len )
+            w -= iov->iov_len, ++iov, --n;
+        if ( n > 0 )
+        {
+            iov->iov_base = (char *)iov->iov_base + w;
+            iov->iov_len -= w;
+        }
+    }
+    return;
+}
+
+/* Writer thread: pass queued messages on to the log file in batches,
+   until stopped and the queue is drained. */
+static void *async_writer_( void *arg )
+{
+    struct iovec iov[ASYNC_BATCH];
+    char out[ASYNC_BATCH][LOG_ASYNC_MSGSZ];
+    struct tstamp tc = TSTAMP_INITIALIZER;
+    struct async_slot *sl;
+    size_t i, n;
+
+    (void)arg;
+    LOCK_LOG();
+    for ( ;; )
+    {
+        while ( 0 == aq.cnt && aq.run )
+            pthread_cond_wait( &aq_nonempty, &mtx );
+        if ( 0 == aq.cnt )
+            break;
+        /* Take the contiguous run of slots starting at the head; they
+           are not reused by producers until the head is advanced. */
+        n = aq.qlen - aq.head;
+        if ( n > aq.cnt )
+            n = aq.cnt;
+        if ( n > ASYNC_BATCH )
+            n = ASYNC_BATCH;
+        sl = aq.slot + aq.head;
+        UNLOCK_LOG();
+        for ( i = 0; i < n; ++i )
+        {
+            if ( 0 != sl[i].len )
+            {
+                iov[i].iov_base = sl[i].u.msg;
+                iov[i].iov_len = sl[i].len;
+            }
+            else
+            {
+                struct sink sk = { NULL, out[i], sizeof out[i], 0 };
+                defer_format_( &sk, &sl[i].u.rec, &tc );
+                iov[i].iov_base = out[i];
+                iov[i].iov_len = async_eol_( out[i], sk.len, sizeof out[i] );
+            }
+        }
+        async_writev_( aq.fd, iov, (int)n );
+        LOCK_LOG();
+        aq.head = ( aq.head + n ) % aq.qlen;
+        aq.cnt -= n;
+        pthread_cond_broadcast( &aq_notfull );
+    }
+    UNLOCK_LOG();
+    return NULL;
+}
+
+/* Set up the queue and start the writer thread. Called with mtx held.
+   Returns 0 on success, or -1 if asynchronous mode is not available. */
+static int async_start_( FILE *fp )
+{
+    if ( NULL != aq.slot || 0 == async_qlen
+         || NULL == ( aq.slot = malloc( async_qlen * sizeof *aq.slot ) ) )
+        return -1;
+    fflush( fp );
+    aq.qlen = async_qlen;
+    aq.policy = async_policy;
+    aq.head = aq.cnt = 0;
+    aq.fd = fileno( fp );
+    aq.run = 1;
+    if ( 0 > aq.fd || 0 != pthread_create( &aq.tid, NULL, async_writer_, NULL ) )
+    {
+        aq.run = 0;
+        free( aq.slot );
+        aq.slot = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Wait for a writer thread being stopped to finish. Called with mtx
+   held. */
+static void async_wait_( void )
+{
+    while ( aq.stopping )
+        pthread_cond_wait( &aq_stopped, &mtx );
+    return;
+}
+
+/* Stop the writer thread after it drained the queue. Called with mtx
+   held, which is temporarily released to let the writer finish; other
+   threads wait in async_wait_() meanwhile. */
+static void async_stop_( void )
+{
+    async_wait_();
+    if ( !aq.run )
+        return;
+    aq.run = 0;
+    aq.stopping = 1;
+    cfg.mode &= ~( LOG_ASYNC | LOG_DEFER );
+    pthread_cond_broadcast( &aq_nonempty );
+    pthread_cond_broadcast( &aq_notfull );
+    UNLOCK_LOG();
+    pthread_join( aq.tid, NULL );
+    LOCK_LOG();
+    free( aq.slot );
+    aq.slot = NULL;
+    aq.stopping = 0;
+    pthread_cond_broadcast( &aq_stopped );
+    return;
+}
+
+static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int option, int facility );
+
+/* Replace the time stamp a formatted line of length len starts with by
+   the current time. Called with mtx held. */
+static void async_restamp_( char *line, size_t len )
+{
+    char stamp[TSTAMP_SZ];
+    size_t k;
+
+    log_now_( stamp );
+    k = strlen( stamp );
+    if ( k < len && ' ' == line[k] )
+        memcpy( line, stamp, k );
+    return;
+}
+
+/* Append a formatted line of length len, or a deferred record of size
+   len, if rec is nonzero, to the queue, applying the overflow policy.
+   The message is stamped in the same critical section that puts it in
+   the queue, thus stamps follow queue order. Should the writer have
+   been stopped since the caller decided to log asynchronously, the
+   message is written synchronously instead. */
+static void async_put_( void *msg, size_t len, int rec )
+{
+    struct async_slot *sl;
+
+    LOCK_LOG();
+    for ( ;; )
+    {
+        async_wait_();
+        if ( !aq.run || aq.cnt < aq.qlen || LOG_ASYNC_BLOCK != aq.policy )
+            break;
+        pthread_cond_wait( &aq_notfull, &mtx );
+    }
+    if ( rec )
+        ntime_to_timeval( ntime_get(), &( (struct defer_rec *)msg )->tv );
+    else
+        async_restamp_( msg, len );
+    if ( aq.run )
+    {
+        if ( aq.cnt < aq.qlen )
+        {
+            sl = &aq.slot[( aq.head + aq.cnt ) % aq.qlen];
+            memcpy( &sl->u, msg, len );
+            sl->len = rec ? 0 : len;
+            ++aq.cnt;
+            pthread_cond_signal( &aq_nonempty );
+        }
+    }
+    else
+    {
+        if ( !cfg.init )
+            log_open_( LOG_DEBUG, LOG_TO_FILE, stderr, NULL, 0, 0 );
+        if ( cfg.mode & LOG_TO_FILE )
+        {
+            if ( rec )
+            {
+                struct sink sk = { cfg.file, NULL, 0, 0 };
+                defer_format_( &sk, msg, &tsc );
+            }
+            else
+                fwrite( msg, 1, len, cfg.file );
+            fflush( cfg.file );
+        }
+    }
+    UNLOCK_LOG();
+    return;
+}
+#endif /* WITH_PTHREAD */
+
 #ifndef WITHOUT_SYSLOG
 #ifndef WITHOUT_OWN_VSYSLOG
     static void vsyslog_( int pri, const char *fmt, va_list arglist )
@@ -106,9 +778,13 @@ static volatile struct {
 
 static void log_close_( void )
 {
+#ifdef WITH_PTHREAD
+    async_stop_();
+#endif
     if ( !cfg.init )
         return;
     cfg.init = 0;
+    log_level_ = LOG_DEBUG;
     if ( (cfg.mode & LOG_TO_FILE) && cfg.file && cfg.file_is_our )
         fclose( cfg.file );
 #ifndef WITHOUT_SYSLOG
@@ -122,10 +798,21 @@ static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int opt
 {
     if ( !cfg.init )
         log_close_();
+#ifdef WITH_PTHREAD
+    async_stop_();
+    if ( mode & LOG_DEFER )
+        mode |= LOG_ASYNC;
+    if ( ( mode & LOG_ASYNC ) && ( !( mode & LOG_TO_FILE )
+                                   || 0 != async_start_( fp ? fp : stderr ) ) )
+        mode &= ~( LOG_ASYNC | LOG_DEFER );
+#else
+    mode &= ~( LOG_ASYNC | LOG_DEFER );
+#endif
     cfg.level = lvl;
     cfg.mode  = mode;
     cfg.ident = id ? id : NULLSTR;
     cfg.file  = fp ? fp : stderr;
+    log_level_ = ( mode & ( LOG_TO_FILE | LOG_TO_SYSLOG ) ) ? lvl : -1;
 #ifndef WITHOUT_SYSLOG
     if ( mode & LOG_TO_SYSLOG )
         openlog( id, option, facility );
@@ -134,6 +821,91 @@ static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int opt
     return;
 }
 
+/* Common part of log_vprintf() and log_xprintf_(). Deferred formatting
+   is only permitted, if fmt is guaranteed to outlive the call. */
+static void log_vprintf_( int pri, const char *fmt, va_list arglist, int defer )
+{
+    int eno = errno;
+    int async = 0;
+    const char *ident = NULL;
+    char stamp[TSTAMP_SZ];
+
+    if ( !log_enabled( pri ) )
+        return;
+    LOCK_LOG();
+#ifdef WITH_PTHREAD
+    async_wait_();
+#endif
+    if ( !cfg.init )
+        log_open_( LOG_DEBUG, LOG_TO_FILE, stderr, NULL, 0, 0 );
+    if ( pri <= cfg.level )
+    {
+#ifndef WITHOUT_SYSLOG
+        if ( cfg.mode & LOG_TO_SYSLOG )
+        {
+            va_list argcopy;
+            va_copy( argcopy, arglist );
+            errno = eno;
+            vsyslog_( pri, fmt, argcopy );
+            va_end( argcopy );
+        }
+#endif
+        if ( cfg.mode & LOG_ASYNC )
+        {
+            /* Format outside the lock, see below. The stamp taken here
+               only reserves its place in the line, async_put_() renews
+               it once the message is queued. */
+            async = 1;
+            ident = cfg.ident;
+            if ( !( cfg.mode & LOG_DEFER ) )
+                defer = 0;
+            if ( !defer )
+                log_now_( stamp );
+        }
+        else if ( cfg.mode & LOG_TO_FILE )
+        {
+            struct sink sk = { cfg.file, NULL, 0, 0 };
+            log_now_( stamp );
+            log_emit_( &sk, stamp, cfg.ident, pri, fmt, arglist, eno );
+            fflush( cfg.file );
+        }
+    }
+    UNLOCK_LOG();
+#ifdef WITH_PTHREAD
+    if ( async && defer )
+    {
+        /* Record the message for the writer thread to format it. */
+        struct defer_rec rec;
+        size_t n;
+        if ( 0 != ( n = defer_record_( &rec, fmt, arglist ) ) )
+        {
+            rec.fmt = fmt;
+            rec.ident = ident;
+            rec.pri = pri;
+            rec.eno = eno;
+            async_put_( &rec, n, 1 );
+            return;
+        }
+        /* Unsupported format string, fall back to formatting here. */
+        LOCK_LOG();
+        log_now_( stamp );
+        UNLOCK_LOG();
+    }
+    if ( async )
+    {
+        char line[LOG_ASYNC_MSGSZ];
+        struct sink sk = { NULL, line, sizeof line, 0 };
+        log_emit_( &sk, stamp, ident, pri, fmt, arglist, eno );
+        async_put_( line, async_eol_( line, sk.len, sizeof line ), 0 );
+    }
+#else
+    (void)async;
+    (void)ident;
+    (void)defer;
+#endif
+    return;
+}
+
 
 /*
  * Exported functions.
@@ -143,7 +915,7 @@ static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int opt
  **** log_printf 3
  **
  ** NAME
- **   log_open, log_fopen, log_printf, log_vprintf, log_xprintf - write formatted messages to a file and/or the system logger
+ **   log_open, log_fopen, log_close, log_async_config, log_printf, log_vprintf, log_xprintf, log_enabled - write formatted messages to a file and/or the system logger
  **
  ** SYNOPSIS
  **   #include <logging.h>
@@ -151,10 +923,12 @@ static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int opt
  **   void log_open(int lvl, unsigned mode, FILE *fp, const char *id, int option, int facility);
  **   void log_fopen(int lvl, unsigned mode, const char *filename, const char *id, int option, int facility);
  **   void log_close(void);
+ **   void log_async_config(size_t qlen, int policy);
  **
  **   void log_printf(int pri, const char *fmt, ...);
  **   void log_vprintf(int pri, const char *fmt, va_list arglist);
  **   log_xprintf(pri, ...)
+ **   log_enabled(pri)
  **
  ** DESCRIPTION
  **   The log_open() function initializes the logging system. Its use
@@ -178,6 +952,19 @@ static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int opt
  **   Both options can be set to 0, if logging to syslog is not enabled,
  **   or logging was built with the -DWITHOUT_SYSLOG compile time setting.
  **
+ **   If LOG_ASYNC is included in mode along with LOG_TO_FILE, messages
+ **   are formatted by the calling thread into a queue slot, and written
+ **   to the file in batches by a dedicated writer thread, so callers do
+ **   not wait for file I/O. The file must not be used otherwise while
+ **   logging asynchronously.
+ **
+ **   If LOG_DEFER is included in mode, which implies LOG_ASYNC, the calling
+ **   thread merely records the format string pointer, priority, time and
+ **   the raw argument values, and leaves all formatting to the writer
+ **   thread. The output is identical to that of the other modes. Messages
+ **   with format strings that cannot be deferred are formatted by the
+ **   calling thread as in LOG_ASYNC mode.
+ **
  **   The log_fopen() function is similar to log_open(), but takes a
  **   filename string instead of a file pointer. Any failure to open the
  **   specified file for appending is silently ignored and any
@@ -185,7 +972,14 @@ static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int opt
  **
  **   The log_close() function closes the logging system. Its use is
  **   optional, as it is implicitly called first thing whenever log_open()
- **   or log_fopen() is called.
+ **   or log_fopen() is called. In LOG_ASYNC mode it waits for all queued
+ **   messages to be written.
+ **
+ **   The log_async_config() function sets the number of queue slots qlen
+ **   and the policy applied when the queue is full, for subsequent calls
+ **   to log_open() or log_fopen() with LOG_ASYNC. For LOG_ASYNC_BLOCK, the
+ **   logging thread waits for a free slot; for LOG_ASYNC_DROP, the message
+ **   is discarded. The defaults are LOG_ASYNC_QLEN and LOG_ASYNC_BLOCK.
  **
  **   The log_printf() function writes a formatted message with priority
  **   pri to the logging system. It provides an interface similar to
@@ -206,9 +1000,18 @@ static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int opt
  **   formatted message. It is guaranteed to evaluate it's arguments
  **   only once.
  **
+ **   The log_enabled() macro tests, whether a message with priority pri
+ **   would currently be logged, without taking any lock. It can be used
+ **   to skip computing expensive arguments for messages that would be
+ **   discarded anyway. The logging functions perform the same check first
+ **   thing, so messages above the cutoff priority are dismissed cheaply.
+ **
  ** RETURN VALUE
  **   These functions do not return any values.
  **
+ **   The log_enabled() macro yields a nonzero value, if messages of
+ **   priority pri are logged, or zero otherwise.
+ **
  ** NOTES
  **   The log_open() and log_fopen() functions can safely be called
  **   repeatedly to reconfigure the logging system on the fly, without
@@ -232,6 +1035,22 @@ static void log_open_( int lvl, unsigned mode, FILE *fp, const char *id, int opt
  **     PRI  priority
  **     MSG  formatted message
  **
+ **   In LOG_DEFER mode the format string passed to log_printf() or
+ **   log_vprintf() is accessed after the call has returned, thus it must
+ **   remain valid and unchanged until log_close() is called; usually it is
+ **   a string literal anyway. Up to 8 arguments, including '*' field width
+ **   and precision arguments, are supported, and all printf(3) conversions
+ **   except "%n", "%lc", "%ls" and positional "%n$" arguments. String
+ **   arguments are copied; messages whose string arguments take more than
+ **   LOG_ASYNC_MSGSZ / 2 bytes in total, including a terminating null
+ **   character each, are formatted by the calling thread as well.
+ **   The log_xprintf() macro always formats in the calling thread.
+ **
+ **   In LOG_ASYNC mode log lines exceeding LOG_ASYNC_MSGSZ - 1 bytes are
+ **   truncated and terminated by a newline.
+ **   Should the queue or the writer thread fail to be set up, logging
+ **   silently falls back to synchronous mode.
+ **
  ** BUGS
  **   When logging to a file, a terminating newline is not automatically
  **   appended to each message, but must be explicitly included in the
@@ -279,6 +1098,8 @@ void log_close( void )
 void log_printf( int pri, const char *fmt, ... )
 {
     va_list arglist;
+    if ( !log_enabled( pri ) )
+        return;
     va_start( arglist, fmt );
     log_vprintf( pri, fmt, arglist );
     va_end( arglist );
@@ -287,85 +1108,15 @@ void log_printf( int pri, const char *fmt, ... )
 
 void log_vprintf( int pri, const char *fmt, va_list arglist )
 {
-    int eno = errno;
+    log_vprintf_( pri, fmt, arglist, 1 );
+    return;
+}
 
+void log_async_config( size_t qlen, int policy )
+{
     LOCK_LOG();
-    if ( !cfg.init )
-        log_open_( LOG_DEBUG, LOG_TO_FILE, stderr, NULL, 0, 0 );
-    if ( pri <= cfg.level )
-    {
-#ifndef WITHOUT_SYSLOG
-        if ( cfg.mode & LOG_TO_SYSLOG )
-        {
-            va_list argcopy;
-            va_copy( argcopy, arglist );
-            errno = eno;
-            vsyslog_( pri, fmt, argcopy );
-            va_end( argcopy );
-        }
-#endif
-        if ( cfg.mode & LOG_TO_FILE )
-        {
-            /* Write time, ident, pid and priority stamps. */
-            char tbuf[32];
-            struct tm ts;
-            struct timeval tv;
-            ntime_to_timeval( ntime_get(), &tv );
-            localtime_r( &tv.tv_sec, &ts );
-            strftime( tbuf, sizeof tbuf, "%FT%T", &ts );
-            fprintf( cfg.file, "%s.%06d", tbuf, (int)tv.tv_usec );
-            strftime( tbuf, sizeof tbuf, "%z", &ts );
-            fprintf( cfg.file, "%.3s:%s %s[%u]:%d: ", tbuf, tbuf + 3,
-                     cfg.ident, (unsigned)getpid(), pri );
-
-            /* Process any %m sequences embedded in format string. */
-            const char *f = fmt;
-            const char *m = strstr( f, "%m" );
-            if ( m )
-            {
-                /* The POSIX strerror_r() specification does not provide
-                   any means to determine the maximum length of the
-                   resulting string beforehand. The GNU C Library however
-                   uses a buffer of 1024 characters internally, thus we
-                   simply take that as a suitable buffer size and hope
-                   for the best.  N.B.: We expect the XSI-compliant
-                   version of strerror_r()! */
-                char estr[1024];
-                if ( strerror_r( eno, estr, sizeof estr ) )
-                    snprintf( estr, sizeof estr, "Error %d occurred", eno );
-                /* Incrementally write the formatted message, handle
-                   all %m sequences in format string. */
-                do
-                {
-                    /* Keep %%m, do not replace! */
-                    int have_ppm;
-                    have_ppm = ( m > f && m[-1] == '%' );
-                    if ( have_ppm )
-                        m += 2;
-                    /* Write partial message using temporary format string. */
-                    char xfmt[m-f+1];
-                    strncpy( xfmt, f, m-f );
-                    xfmt[m-f] = '\0';
-                    vfprintf( cfg.file, xfmt, arglist );
-                    /* Write replacement text only for a genuine %m! */
-                    if ( !have_ppm )
-                    {
-                        fputs( estr, cfg.file );
-                        m += 2;
-                    }
-                    /* Continue with next %m sequence, if any. */
-                    f = m;
-                    m = strstr( f, "%m" );
-                }
-                while ( m );
-            }
-
-            /* Write remainder of message - i.e. all of it, if no %m
-               was present in the format string to begin with. */
-            vfprintf( cfg.file, f, arglist );
-            fflush( cfg.file );
-        }
-    }
+    async_qlen = qlen;
+    async_policy = policy;
     UNLOCK_LOG();
     return;
 }
@@ -374,6 +1125,9 @@ void log_vprintf( int pri, const char *fmt, va_list arglist )
    exclusively as the expansion target of the log_xprintf() macro! */
 void log_xprintf_( const char *file, const char *func, int line, int pri, const char *fmt, ... )
 {
+    if ( !log_enabled( pri ) )
+        return;
+
     int eno = errno;
     va_list arglist;
     int n = snprintf( NULL, 0, "(%s:%s:%d) %s", file, func, line, fmt );
@@ -382,7 +1136,7 @@ void log_xprintf_( const char *file, const char *func, int line, int pri, const
     snprintf( xfmt, sizeof xfmt, "(%s:%s:%d) %s", file, func, line, fmt );
     errno = eno;
     va_start( arglist, fmt );
-    log_vprintf( pri, xfmt, arglist );
+    log_vprintf_( pri, xfmt, arglist, 0 );
     va_end( arglist );
     return;
 }
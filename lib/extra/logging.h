@@ -47,6 +47,18 @@
  **     together to form the mode option of log_open():
  **     LOG_TO_FILE     Log to a user supplied file pointer.
  **     LOG_TO_SYSLOG   Log to system log.
+ **     LOG_ASYNC       Hand file output over to a writer thread.
+ **     LOG_DEFER       Also defer formatting to the writer thread;
+ **                     implies LOG_ASYNC.
+ **
+ **     The following symbolic constants select the LOG_ASYNC queue
+ **     overflow policy passed to log_async_config():
+ **     LOG_ASYNC_BLOCK  Wait for the writer to free a queue slot.
+ **     LOG_ASYNC_DROP   Discard the message.
+ **
+ **     LOG_ASYNC_QLEN   Default number of LOG_ASYNC queue slots.
+ **     LOG_ASYNC_MSGSZ  Size of a queue slot, i.e. the maximum length
+ **                      of a log line in LOG_ASYNC mode.
  **
  **     The following symbolic constants, borrowed from syslog.h(7),
  **     are to be used as the lvl argument of log_open() and log_fopen(),
@@ -66,10 +78,16 @@
  **
  **     log_xprintf(PRI, ...)
  **
+ **     A function-like macro to test whether a message of a given
+ **     priority would be logged at all:
+ **
+ **     log_enabled(PRI)
+ **
  **   FUNCTIONS
  **     log_open()     initialize the logging system
  **     log_fopen()    initialize the logging system
  **     log_close()    close the logging system
+ **     log_async_config()  configure the LOG_ASYNC queue
  **
  **     log_printf()   log a formatted message
  **
@@ -80,6 +98,10 @@
  **   the file logging mode is available and LOG_TO_SYSLOG is silently
  **   ignored.
  **
+ **   The LOG_ASYNC and LOG_DEFER modes are only available if the logging
+ **   module was built with -DWITH_PTHREAD, otherwise they are silently
+ **   ignored.
+ **
  ** SEE ALSO
  **   log_printf(3), syslog(3), syslog.h(7)
  **
@@ -98,6 +120,16 @@ extern "C" {
 /* Supported logging modes. */
 #define LOG_TO_FILE     1
 #define LOG_TO_SYSLOG   2
+#define LOG_ASYNC       4
+#define LOG_DEFER       8
+
+/* LOG_ASYNC queue overflow policies. */
+#define LOG_ASYNC_BLOCK 0
+#define LOG_ASYNC_DROP  1
+
+/* LOG_ASYNC default queue length and slot size. */
+#define LOG_ASYNC_QLEN  256
+#define LOG_ASYNC_MSGSZ 512
 
 /* Priority levels, borrowed from syslog.h. */
 #ifndef LOG_EMERG
@@ -129,6 +161,7 @@ extern "C" {
 void log_open( int lvl, unsigned mode, FILE *fp, const char *id, int option, int facility );
 void log_fopen( int lvl, unsigned mode, const char *filename, const char *id, int option, int facility );
 void log_close( void );
+void log_async_config( size_t qlen, int policy );
 
 void log_printf( int pri, const char *fmt, ... );
 
@@ -138,6 +171,10 @@ void log_vprintf( int pri, const char *fmt, va_list arglist );
 void log_xprintf_( const char *file, const char *func, int line, int pri, const char *fmt, ... );
 #define log_xprintf(PRI, ...)    log_xprintf_( __FILE__, __func__, __LINE__, (PRI), __VA_ARGS__ )
 
+/* NOTE: Never access log_level_ directly, always use the log_enabled() macro instead! */
+extern volatile int log_level_;
+#define log_enabled(PRI)    ((PRI) <= log_level_)
+
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,238 @@
+/*
+ * utf8_par.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#ifdef WITH_PTHREAD
+    #if defined(_POSIX_C_SOURCE) && (_POSIX_C_SOURCE < 200112L)
+        #undef _POSIX_C_SOURCE
+    #endif
+    #ifndef _POSIX_C_SOURCE
+        #define _POSIX_C_SOURCE 200112L
+    #endif
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+#include <stddef.h>
+
+#include <utf8_decode.h>
+#include <utf8_par.h>
+
+#include "../inc_priv/utf8_indec.h"
+#include "../inc_priv/utf8_valid.h"
+
+
+#ifdef WITH_PTHREAD
+
+/* Work item: one chunk, validated as if it started on a sequence
+   boundary, i.e. with the DFA in its initial state. */
+typedef struct {
+    const unsigned char *p;
+    const unsigned char *end;
+    size_t ok;
+    size_t bad;
+    int st;
+} par_job_t;
+
+static void *par_run( void *arg )
+{
+    par_job_t *job = arg;
+
+    job->ok = job->bad = 0;
+    job->st = utf8_count_run( job->p, job->end, UTF8_ACCEPT, &job->ok, &job->bad );
+    return NULL;
+}
+
+/* Feed a single byte to the DFA and update the counts. */
+static inline int par_step( int st, unsigned char b, size_t *ok, size_t *bad )
+{
+    st = utf8_v( b, st );
+    if ( UTF8_ACCEPT == st )
+        ++*ok;
+    else if ( UTF8_REJECT == st )
+        ++*bad, st = UTF8_ACCEPT;
+    return st;
+}
+
+/* Add the results of job to the running totals, given that the
+   sequential DFA actually enters the chunk in state st, and return
+   the state it leaves the chunk in. Where st differs from the initial
+   state the job assumed, both are advanced in lockstep until they
+   agree; from that point on the job's counts are exact, so only the
+   counts for the bytes up to there need to be exchanged. */
+static int par_merge( const par_job_t *job, int st, size_t *ok, size_t *bad )
+{
+    const unsigned char *p = job->p;
+    int js = UTF8_ACCEPT;
+    size_t rok = 0, rbad = 0, jok = 0, jbad = 0;
+
+    while ( st != js && p < job->end )
+    {
+        st = par_step( st, *p, &rok, &rbad );
+        js = par_step( js, *p, &jok, &jbad );
+        ++p;
+    }
+    if ( st != js )
+    {
+        /* Never in sync, the whole chunk was just redone. */
+        *ok += rok;
+        *bad += rbad;
+        return st;
+    }
+    *ok += job->ok - jok + rok;
+    *bad += job->bad - jbad + rbad;
+    return job->st;
+}
+
+#endif /* WITH_PTHREAD */
+
+
+/*
+ **** utf8_mem_count_par 3
+ **
+ ** NAME
+ **   utf8_mem_count_par - count UTF-8 encoded sequences using several threads
+ **
+ ** SYNOPSIS
+ **   #include <utf8_decode.h>
+ **   #include <utf8_par.h>
+ **
+ **   size_t utf8_mem_count_par(void *s, size_t size, size_t *errcnt, int nthreads);
+ **
+ ** DESCRIPTION
+ **   The utf8_mem_count_par() function counts the well formed and the
+ **   malformed UTF-8 sequences in the first size bytes of the memory
+ **   area pointed to by s, just like utf8_mem_count(3), but splits the
+ **   work across up to nthreads threads. If nthreads is zero or negative,
+ **   the number of online processors is used instead. The number of
+ **   threads is further limited to UTF8_PAR_MAX_THREADS, and so that each
+ **   thread gets at least UTF8_PAR_MIN_CHUNK bytes to work on. The calling
+ **   thread takes its share of the work, too.
+ **
+ **   The chunk boundaries are moved past continuation bytes, so they
+ **   usually coincide with sequence boundaries. Where a chunk still
+ **   does not start in the state the preceding data leaves the decoder
+ **   in, e.g. after a truncated sequence, the start of that chunk is
+ **   re-examined after all threads have finished, until both views agree.
+ **   The results are hence always the same utf8_mem_count(3) reports.
+ **
+ **   If errcnt is not NULL, the number of malformed sequences is stored
+ **   in *errcnt.
+ **
+ ** RETURN VALUE
+ **   The utf8_mem_count_par() function returns the number of well formed
+ **   UTF-8 sequences.
+ **
+ ** NOTES
+ **   Threads are created anew for each call, which only pays off for
+ **   large buffers. If a thread cannot be created, its chunk is processed
+ **   by the calling thread.
+ **
+ **   When built without -DWITH_PTHREAD, utf8_mem_count_par() simply
+ **   calls utf8_mem_count(3).
+ **
+ ** SEE ALSO
+ **   utf8_mem_count(3)
+ **
+ */
+
+#ifdef WITH_PTHREAD
+
+size_t utf8_mem_count_par( void *s, size_t size, size_t *errcnt, int nthreads )
+{
+    const unsigned char *p = s;
+    par_job_t job[UTF8_PAR_MAX_THREADS];
+    pthread_t tid[UTF8_PAR_MAX_THREADS];
+    int started[UTF8_PAR_MAX_THREADS];
+    size_t ok = 0, bad = 0, chunk, off, k;
+    int i, n, st;
+
+    if ( nthreads <= 0 )
+    {
+        long ncpu = sysconf( _SC_NPROCESSORS_ONLN );
+        nthreads = ncpu > 0 ? ( ncpu < UTF8_PAR_MAX_THREADS ? ncpu : UTF8_PAR_MAX_THREADS ) : 1;
+    }
+    if ( nthreads > UTF8_PAR_MAX_THREADS )
+        nthreads = UTF8_PAR_MAX_THREADS;
+    if ( (size_t)nthreads > size / UTF8_PAR_MIN_CHUNK )
+        nthreads = size / UTF8_PAR_MIN_CHUNK;
+    if ( nthreads < 2 )
+        return utf8_mem_count( s, size, errcnt );
+
+    /* Split, moving each boundary past up to three continuation bytes. */
+    n = nthreads;
+    chunk = size / n;
+    job[0].p = p;
+    for ( i = 1; i < n; ++i )
+    {
+        off = i * chunk;
+        for ( k = 0; k < 3 && off < size && 0x80 == ( p[off] & 0xc0 ); ++k )
+            ++off;
+        if ( p + off < job[i - 1].p )
+            off = job[i - 1].p - p;
+        job[i].p = job[i - 1].end = p + off;
+    }
+    job[n - 1].end = p + size;
+
+    for ( i = 1; i < n; ++i )
+        started[i] = 0 == pthread_create( &tid[i], NULL, par_run, &job[i] );
+    par_run( &job[0] );
+    for ( i = 1; i < n; ++i )
+    {
+        if ( started[i] )
+            pthread_join( tid[i], NULL );
+        else
+            par_run( &job[i] );
+    }
+
+    st = UTF8_ACCEPT;
+    for ( i = 0; i < n; ++i )
+        st = par_merge( &job[i], st, &ok, &bad );
+    if ( UTF8_ACCEPT != st )
+        ++bad;
+    if ( NULL != errcnt )
+        *errcnt = bad;
+    return ok;
+}
+
+#else
+
+size_t utf8_mem_count_par( void *s, size_t size, size_t *errcnt, int nthreads )
+{
+    (void)nthreads;
+    return utf8_mem_count( s, size, errcnt );
+}
+
+#endif /* WITH_PTHREAD */
+
+/* EOF */
@@ -0,0 +1,79 @@
+/*
+ * utf8_par.h
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ **** utf8_par_h 3
+ **
+ ** NAME
+ **   utf8_par - multi-threaded UTF-8 validation
+ **
+ ** SYNOPSIS
+ **   #include <utf8_par.h>
+ **
+ ** DESCRIPTION
+ **
+ **   MACROS
+ **     UTF8_PAR_MAX_THREADS  maximum number of threads used per call
+ **     UTF8_PAR_MIN_CHUNK    minimum number of bytes handed to a thread
+ **
+ **   FUNCTIONS
+ **     utf8_mem_count_par()  count UTF-8 sequences using several threads
+ **
+ ** SEE ALSO
+ **   utf8_decode_h(3)
+ **
+ */
+
+#ifndef UTF8_PAR_H_INCLUDED
+#define UTF8_PAR_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#define UTF8_PAR_MAX_THREADS    64
+#define UTF8_PAR_MIN_CHUNK      (64 * 1024)
+
+extern size_t utf8_mem_count_par( void *s, size_t size, size_t *errcnt, int nthreads );
+
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif  /* ndef UTF8_PAR_H_INCLUDED */
+
+/* EOF */
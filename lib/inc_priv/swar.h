@@ -0,0 +1,105 @@
+/*
+ * swar.h
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ * This _private_ utlib header provides portable "SIMD within a register"
+ * helpers, that allow to inspect eight bytes at a time using nothing but
+ * ordinary 64-bit integer arithmetic.
+ *
+ * The swar_has*() predicate macros only answer the question whether _any_
+ * byte of a word matches; they do not reliably identify _which_ byte it
+ * was.
+ *
+ */
+
+#ifndef SWAR_H_INCLUDED
+#define SWAR_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+/* Number of bytes processed per word. */
+#define SWAR_SZ         8
+
+#define SWAR_ONES       UINT64_C(0x0101010101010101)
+#define SWAR_HIGH       UINT64_C(0x8080808080808080)
+
+/* Load a word from arbitrarily aligned memory. */
+static inline uint64_t swar_ld( const void *p )
+{
+    uint64_t w;
+    memcpy( &w, p, sizeof w );
+    return w;
+}
+
+/* Nonzero, if any byte in w has its most significant bit set. */
+#define swar_hashigh(w)     ((w) & SWAR_HIGH)
+
+/* Nonzero, if any byte in w is less than n, where 0 < n <= 128. */
+#define swar_hasless(w,n)   (((w) - SWAR_ONES * (n)) & ~(w) & SWAR_HIGH)
+
+/* Nonzero, if any byte in w is zero. */
+#define swar_haszero(w)     swar_hasless((w),1)
+
+/* Nonzero, if any byte in w equals c. */
+#define swar_hasbyte(w,c)   swar_haszero((w) ^ (SWAR_ONES * (uint8_t)(c)))
+
+/* The following macros yield exact per-byte results, but only work for
+   words containing 7-bit values: the most significant bit of each byte
+   in the result is set, if the condition holds for that byte.
+   The arguments lo, hi and c shall be less than 128. */
+#define swar_m_ge(w,lo)     ((((w) | SWAR_HIGH) - SWAR_ONES * (lo)) & SWAR_HIGH)
+#define swar_m_le(w,hi)     ((SWAR_ONES * (0x80 | (hi)) - (w)) & SWAR_HIGH)
+#define swar_m_in(w,lo,hi)  (swar_m_ge((w),(lo)) & swar_m_le((w),(hi)))
+#define swar_m_eq(w,c)      (~(((w) ^ (SWAR_ONES * (c))) + SWAR_ONES * 0x7f) & SWAR_HIGH)
+
+/* Flags UTF-8 continuation bytes (10xxxxxx), for any byte values. */
+#define swar_m_cont(w)      ((w) & ~((w) << 1) & SWAR_HIGH)
+
+/* Number of bytes flagged in a mask, i.e. a word with only the most
+   significant bits of bytes set, as produced by the macros above. */
+#define swar_cnt(m)         ((size_t)((((m) >> 7) * SWAR_ONES) >> 56))
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* ndef SWAR_H_INCLUDED */
+
+/* EOF */
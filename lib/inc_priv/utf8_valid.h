@@ -0,0 +1,156 @@
+/*
+ * utf8_valid.h
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ * This _private_ utlib header provides a fast path to check and decode
+ * single well formed UTF-8 sequences, as an alternative to the DFA in
+ * utf8_indec.h. The lead byte is classified by its high bits, the
+ * continuation bytes are checked all at once, and overlong forms,
+ * surrogates and values beyond U+10FFFF are rejected based on the
+ * decoded value, as per table 3-7 of the Unicode standard. Unlike the
+ * DFA there is no serial dependency between the steps for consecutive
+ * bytes, which allows the processor to overlap them. Anything rejected
+ * is left to the DFA, which also takes care of the error accounting.
+ *
+ */
+
+#ifndef UTF8_VALID_H_INCLUDED
+#define UTF8_VALID_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "swar.h"
+#include "utf8_indec.h"
+
+/*
+ * Decode a well formed multibyte sequence starting at p, with avail
+ * bytes available. Returns the sequence length
+ * and stores the code point in *cp, or returns 0 for anything else.
+ * The checks for overlong forms and surrogates are done on the decoded
+ * value, which is cheaper than a lookup of the second byte range.
+ */
+static inline size_t utf8_seq_decode( const unsigned char *p, size_t avail, uint32_t *cp )
+{
+    uint32_t c;
+
+    if ( 0xc0 == ( p[0] & 0xe0 ) )
+    {
+        if ( avail < 2 || p[0] < 0xc2 || 0x80 != ( p[1] & 0xc0 ) )
+            return 0;
+        *cp = ( p[0] & 0x1fu ) << 6 | ( p[1] & 0x3fu );
+        return 2;
+    }
+    if ( 0xe0 == ( p[0] & 0xf0 ) )
+    {
+        if ( avail < 3 || 0x80 != ( ( p[1] & p[2] ) & 0xc0 )
+             || 0x80 != ( ( p[1] | p[2] ) & 0xc0 ) )
+            return 0;
+        c = ( p[0] & 0x0fu ) << 12 | ( p[1] & 0x3fu ) << 6 | ( p[2] & 0x3fu );
+        if ( c < 0x800 || 0xd800 == ( c & 0xf800 ) )
+            return 0;
+        *cp = c;
+        return 3;
+    }
+    if ( 0xf0 == ( p[0] & 0xf8 ) )
+    {
+        if ( avail < 4 || 0x80 != ( ( p[1] & p[2] & p[3] ) & 0xc0 )
+             || 0x80 != ( ( p[1] | p[2] | p[3] ) & 0xc0 ) )
+            return 0;
+        c = ( p[0] & 0x07u ) << 18 | ( p[1] & 0x3fu ) << 12
+            | ( p[2] & 0x3fu ) << 6 | ( p[3] & 0x3fu );
+        if ( c - 0x10000 > 0xfffff )
+            return 0;
+        *cp = c;
+        return 4;
+    }
+    return 0;
+}
+
+/*
+ * Validate the bytes from p up to end, starting in DFA state st, and
+ * add the numbers of well formed and malformed sequences to *ok and
+ * *bad, respectively. Returns the DFA state after the last byte, an
+ * incomplete trailing sequence is not counted. ASCII is skipped word
+ * by word and well formed sequences are taken in one step, all else
+ * is left to the DFA to obtain the exact counts.
+ */
+static inline int utf8_count_run( const unsigned char *p, const unsigned char *end,
+                                  int st, size_t *ok, size_t *bad )
+{
+    size_t good = 0, err = 0, n;
+    uint32_t cp;
+
+    while ( p < end )
+    {
+        if ( UTF8_ACCEPT == st )
+        {
+            if ( *p < 0x80 )
+            {
+                while ( end - p >= SWAR_SZ && !swar_hashigh( swar_ld( p ) ) )
+                    good += SWAR_SZ, p += SWAR_SZ;
+                if ( p == end )
+                    break;
+            }
+            n = *p < 0x80 ? 1 : utf8_seq_decode( p, end - p, &cp );
+            if ( 0 != n )
+            {
+                ++good;
+                p += n;
+                continue;
+            }
+        }
+        st = utf8_v( *p, st );
+        if ( UTF8_ACCEPT == st )
+            ++good;
+        else if ( UTF8_REJECT == st )
+            ++err, st = UTF8_ACCEPT;
+        ++p;
+    }
+    *ok += good;
+    *bad += err;
+    return st;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* ndef UTF8_VALID_H_INCLUDED */
+
+/* EOF */
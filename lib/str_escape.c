@@ -79,26 +79,48 @@ ISO/IEC 9899:201x N1570 p67 defines these escape-sequences:
         \x hexadecimal-digit
         hexadecimal-escape-sequence hexadecimal-digit
 
+
+RFC8259 sect. 7 requires these characters to be escaped in JSON strings:
+
+    quotation mark, reverse solidus, and the control characters
+    U+0000 through U+001F
+
+    escape = %x5C
+        %x22 /  ; "    quotation mark  U+0022
+        %x5C /  ; \    reverse solidus U+005C
+        %x2F /  ; /    solidus         U+002F  <-- never generated here
+        %x62 /  ; b    backspace       U+0008
+        %x66 /  ; f    form feed       U+000C
+        %x6E /  ; n    line feed       U+000A
+        %x72 /  ; r    carriage return U+000D
+        %x74 /  ; t    tab             U+0009
+        %x75 4HEXDIG ; uXXXX           U+XXXX
+
 */
 
+
 #include <stddef.h>
+#include <string.h>
 
 #include <str_escape.h>
 
 #include <inc_priv/baseconv.h>
+#include <inc_priv/swar.h>
+#include <inc_priv/utf8_indec.h>
 
 #define ESC_URL_MASK  0x01
 #define ESC_NUM_MASK  0x02
 #define ESC_SYM_MASK  0x04
+#define ESC_JSN_MASK  0x08
 
 static const unsigned char esc_d[] = {
 /*        _0 _1 _2 _3 _4 _5 _6 _7  _8 _9 _a _b _c _d _e _f */
-/* 0_ */   7, 3, 3, 3, 3, 3, 3, 7,  7, 7, 7, 7, 7, 7, 3, 3,
-/* 1_ */   3, 3, 3, 3, 3, 3, 3, 3,  3, 3, 3, 3, 3, 3, 3, 3,
-/* 2_ */   1, 1, 7, 1, 1, 1, 1, 1,  1, 1, 1, 1, 1, 0, 0, 1,
+/* 0_ */  15,11,11,11,11,11,11,15, 15,15,15,15,15,15,11,11,
+/* 1_ */  11,11,11,11,11,11,11,11, 11,11,11,11,11,11,11,11,
+/* 2_ */   1, 1,15, 1, 1, 1, 1, 1,  1, 1, 1, 1, 1, 0, 0, 1,
 /* 3_ */   0, 0, 0, 0, 0, 0, 0, 0,  0, 0, 1, 1, 1, 1, 1, 1,
 /* 4_ */   1, 0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0, 0, 0, 0,
-/* 5_ */   0, 0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 1, 7, 1, 1, 0,
+/* 5_ */   0, 0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 1,15, 1, 1, 0,
 /* 6_ */   1, 0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0, 0, 0, 0,
 /* 7_ */   0, 0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 1, 1, 1, 0, 1,
 };
@@ -106,6 +128,7 @@ static const unsigned char esc_d[] = {
 #define ESC_URL(c)  ((c & 0x80) || (esc_d[(c)] & ESC_URL_MASK))
 #define ESC_NUM(c)  ((c & 0x80) || (esc_d[(c)] & ESC_NUM_MASK))
 #define ESC_SYM(c) (!(c & 0x80) && (esc_d[(c)] & ESC_SYM_MASK))
+#define ESC_JSN(c) (!(c & 0x80) && (esc_d[(c)] & ESC_JSN_MASK))
 
 static const char *sym =
         "0......abtnvfr.."     /* 00 .. 0f */
@@ -116,17 +139,83 @@ static const char *sym =
         "............\\..."    /* 50 .. 5f */
         ;
 
+static const char *jsym =
+        "........btn.fr.."     /* 00 .. 0f */
+        "................"     /* 10 .. 1f */
+        "..\"............."    /* 20 .. 2f */
+        "................"     /* 30 .. 3f */
+        "................"     /* 40 .. 4f */
+        "............\\..."    /* 50 .. 5f */
+        ;
+
+/* Word-wise counterparts of the character class macros above: nonzero,
+   if any byte in w needs closer inspection. */
+#define ESC_RUN_C     0
+#define ESC_RUN_JSN   1
+#define ESC_RUN_URL   2
+
+#define ESC_WORD(w)  ( swar_hashigh(w) || swar_hasless((w),0x20) \
+                       || swar_hasbyte((w),'"') || swar_hasbyte((w),'\\') )
+#define JSN_WORD(w)  ( swar_hasless((w),0x20) \
+                       || swar_hasbyte((w),'"') || swar_hasbyte((w),'\\') )
+#define URL_WORD(w)  ( swar_hashigh(w) || SWAR_HIGH != ( \
+                         swar_m_in((w),'0','9') | swar_m_in((w),'A','Z') \
+                       | swar_m_in((w),'a','z') | swar_m_in((w),'-','.') \
+                       | swar_m_eq((w),'_') | swar_m_eq((w),'~') ) )
+
+/* Store k bytes from b at offset n in buf, if space permits. */
+static inline size_t esc_put( char *buf, size_t sz, size_t n, size_t *e, const char *b, size_t k )
+{
+    if ( n + k < sz )
+    {
+        memcpy( buf + n, b, k );
+        *e = n + k;
+    }
+    return n + k;
+}
+
+/* Copy a run of characters that need no escaping word by word, stop at
+   the first word that needs closer inspection. */
+static inline const unsigned char *esc_run( char *buf, size_t sz, size_t *n, size_t *e,
+                        const unsigned char *p, const unsigned char *end, int run )
+{
+    uint64_t w;
+
+    while ( end - p >= SWAR_SZ )
+    {
+        w = swar_ld( p );
+        if ( ESC_RUN_JSN == run ? JSN_WORD( w )
+            : ESC_RUN_URL == run ? URL_WORD( w ) : ESC_WORD( w ) )
+            break;
+        if ( *n + SWAR_SZ < sz )
+        {
+            memcpy( buf + *n, p, SWAR_SZ );
+            *e = *n + SWAR_SZ;
+        }
+        else if ( *n + 1 < sz )
+            break;  /* Let the caller fill up the remaining space. */
+        *n += SWAR_SZ;
+        p += SWAR_SZ;
+    }
+    return p;
+}
+
 /*
  **** str_escape 3
  **
  ** NAME
- **   str_escape, str_urlencode - escape special characters in a string
+ **   str_escape, str_urlencode, str_jsonescape, mem_escape, mem_urlencode, mem_jsonescape - escape special characters in a string
  **
  ** SYNOPSIS
  **   #include <str_escape.h>
  **
  **   size_t str_escape(char *buf, size_t sz, const char *s);
  **   size_t str_urlencode(char *buf, size_t sz, const char *s);
+ **   size_t str_jsonescape(char *buf, size_t sz, const char *s, size_t *errcnt);
+ **
+ **   size_t mem_escape(char *buf, size_t sz, const void *s, size_t len);
+ **   size_t mem_urlencode(char *buf, size_t sz, const void *s, size_t len);
+ **   size_t mem_jsonescape(char *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
  **
  ** DESCRIPTION
  **   The str_escape() function copies characters from the null
@@ -141,12 +230,28 @@ static const char *sym =
  **   characters according to RFC3986 sect. 2.2, to URL encode
  **   ("percent-encode") the string.
  **
+ **   The str_jsonescape() function works similar, but escapes special
+ **   characters according to RFC8259 sect. 7, so the result can be used
+ **   as the contents of a JSON string. Quotation mark, reverse solidus
+ **   and the control characters '\\b', '\\f', '\\n', '\\r' and '\\t' are
+ **   replaced by their symbolic escape sequences, all other control
+ **   characters by a '\\u00XX' escape sequence.
+ **   If errcnt is NULL, all other characters are copied verbatim.
+ **   Otherwise the source is additionally validated as UTF-8: each
+ **   malformed sequence is replaced by a '\\ufffd' escape sequence
+ **   (denoting the Unicode replacement character) and the number of
+ **   malformed sequences is stored in *errcnt.
+ **
+ **   The mem_escape(), mem_urlencode() and mem_jsonescape() functions
+ **   are similar to their str_ counterparts, except they inspect exactly
+ **   len bytes from the array s and do not treat null bytes special.
+ **
  ** RETURN VALUE
- **   The str_escape() and str_urlencode() functions return the total
- **   number of bytes required for the conversion (excluding the null
- **   byte used to terminate the string). In particular, if the returned
- **   value is less than sz, there was sufficient space in buf and the
- **   conversion was successful.
+ **   All of these functions return the total number of bytes required
+ **   for the conversion (excluding the null byte used to terminate the
+ **   string). In particular, if the returned value is less than sz,
+ **   there was sufficient space in buf and the conversion was
+ **   successful.
  **
  ** NOTES
  **   While it would be feasible to generate hexadecimal instead of
@@ -156,18 +261,30 @@ static const char *sym =
  **   grammar production for hexadecimal escape sequences in the C
  **   standard.
  **
+ **   The number of malformed UTF-8 sequences reported by str_jsonescape()
+ **   is the same as reported by utf8_str_count(3) for the same string.
+ **
+ **   The str_ variants determine the length of s first and then call
+ **   their mem_ counterparts. Since the length of the input is known
+ **   in advance, runs of characters that need no escaping are inspected
+ **   and copied a word at a time.
+ **
  ** SEE ALSO
- **   str_unescape(3), str_urldecode(3)
+ **   str_unescape(3), str_urldecode(3), utf8_str_count(3)
  **
  */
 
-size_t str_escape( char *buf, size_t sz, const char *s )
+size_t mem_escape( char *buf, size_t sz, const void *s, size_t len )
 {
-    const unsigned char *p = (const unsigned char *)s;
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
     size_t n, e;
 
-    for ( n = e = 0; *p; ++p )
+    for ( n = e = 0; p < end; ++p )
     {
+        p = esc_run( buf, sz, &n, &e, p, end, ESC_RUN_C );
+        if ( p == end )
+            break;
         if ( ESC_SYM( *p ) )
         {
             if ( n + 2 < sz )
@@ -207,13 +324,17 @@ size_t str_escape( char *buf, size_t sz, const char *s )
     return n;
 }
 
-size_t str_urlencode( char *buf, size_t sz, const char *s )
+size_t mem_urlencode( char *buf, size_t sz, const void *s, size_t len )
 {
-    const unsigned char *p = ( const unsigned char *)s;
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
     size_t n, e;
 
-    for ( n = e = 0; *p; ++p )
+    for ( n = e = 0; p < end; ++p )
     {
+        p = esc_run( buf, sz, &n, &e, p, end, ESC_RUN_URL );
+        if ( p == end )
+            break;
         if ( ESC_URL( *p ) )
         {
             if ( n + 3 < sz )
@@ -241,4 +362,215 @@ size_t str_urlencode( char *buf, size_t sz, const char *s )
     return n;
 }
 
+size_t mem_jsonescape( char *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
+    const unsigned char *q = p;
+    char b[6] = { '\\', 'u', '0', '0', 0, 0 };
+    size_t n = 0, e = 0, bad = 0;
+    int st = UTF8_ACCEPT;
+
+    for ( ; p < end; ++p )
+    {
+        if ( UTF8_ACCEPT == st )
+        {
+            /* Without validation any byte with the high bit set is an
+               ordinary character, the C-style predicate covers both. */
+            p = esc_run( buf, sz, &n, &e, p, end, errcnt ? ESC_RUN_C : ESC_RUN_JSN );
+            if ( p == end )
+                break;
+        }
+        if ( errcnt && ( UTF8_ACCEPT != st || ( *p & 0x80 ) ) )
+        {
+            /* Only copy complete, well-formed UTF-8 sequences. */
+            if ( UTF8_ACCEPT == st )
+                q = p;
+            st = utf8_v( *p, st );
+            if ( UTF8_ACCEPT == st )
+                n = esc_put( buf, sz, n, &e, (const char *)q, p + 1 - q );
+            else if ( UTF8_REJECT == st )
+            {
+                ++bad;
+                st = UTF8_ACCEPT;
+                n = esc_put( buf, sz, n, &e, "\\ufffd", 6 );
+            }
+        }
+        else if ( ESC_JSN( *p ) )
+        {
+            if ( '.' != jsym[*p] )
+            {
+                b[1] = jsym[*p];
+                n = esc_put( buf, sz, n, &e, b, 2 );
+                b[1] = 'u';
+            }
+            else
+            {
+                b[4] = DTOX(*p >> 4);
+                b[5] = DTOX(*p);
+                n = esc_put( buf, sz, n, &e, b, 6 );
+            }
+        }
+        else
+            n = esc_put( buf, sz, n, &e, (const char *)p, 1 );
+    }
+    /* Handle dangling incomplete sequence. */
+    if ( UTF8_ACCEPT != st )
+    {
+        ++bad;
+        n = esc_put( buf, sz, n, &e, "\\ufffd", 6 );
+    }
+    buf[e] = '\0';
+    if ( errcnt )
+        *errcnt = bad;
+    return n;
+}
+
+size_t str_escape( char *buf, size_t sz, const char *s )
+{
+    return mem_escape( buf, sz, s, strlen( s ) );
+}
+
+size_t str_urlencode( char *buf, size_t sz, const char *s )
+{
+    return mem_urlencode( buf, sz, s, strlen( s ) );
+}
+
+size_t str_jsonescape( char *buf, size_t sz, const char *s, size_t *errcnt )
+{
+    return mem_jsonescape( buf, sz, s, strlen( s ), errcnt );
+}
+
+
+/*
+ **** str_escape_update 3
+ **
+ ** NAME
+ **   str_escape_update, str_urlencode_update - escape special characters in a data stream
+ **
+ ** SYNOPSIS
+ **   #include <str_escape.h>
+ **
+ **   size_t str_escape_update(char *buf, size_t sz, const void *s, size_t len, size_t *consumed);
+ **   size_t str_urlencode_update(char *buf, size_t sz, const void *s, size_t len, size_t *consumed);
+ **
+ ** DESCRIPTION
+ **   The str_escape_update() and str_urlencode_update() functions
+ **   perform the same conversions as str_escape(3) and str_urlencode(3),
+ **   respectively, but process the input in chunks of arbitrary size.
+ **
+ **   Up to len bytes are read from the array s, and the resulting escaped
+ **   data is stored in buf. Null bytes in s are not treated special, and
+ **   buf is not null terminated. Processing stops early before the first
+ **   input character whose escape sequence does not fit in the remaining
+ **   space of the sz bytes available in buf; escape sequences are never
+ **   split. The number of bytes taken from s is stored in *consumed. The
+ **   remaining input has to be passed again in a subsequent call.
+ **   The objects pointed to by buf and s, respectively, shall not overlap.
+ **
+ ** RETURN VALUE
+ **   The str_escape_update() and str_urlencode_update() functions return
+ **   the number of bytes stored in buf.
+ **
+ ** NOTES
+ **   As escaping carries no state from one character to the next, there
+ **   is neither a context object nor a finalization function required,
+ **   unlike with their counterparts str_unescape_update(3) and
+ **   str_urldecode_update(3).
+ **
+ **   To guarantee progress, sz should be at least 4.
+ **
+ ** SEE ALSO
+ **   str_escape(3), str_urlencode(3), str_unescape_update(3)
+ **
+ */
+
+/* Store the escape sequence for c in b, return its length. */
+static inline size_t esc_seq_c( unsigned char c, char *b )
+{
+    if ( ESC_SYM( c ) )
+    {
+        b[0] = '\\';
+        b[1] = sym[c];
+        return 2;
+    }
+    if ( ESC_NUM( c ) )
+    {
+        b[0] = '\\';
+        b[1] = DTOO(c >> 6);
+        b[2] = DTOO(c >> 3);
+        b[3] = DTOO(c);
+        return 4;
+    }
+    b[0] = c;
+    return 1;
+}
+
+static inline size_t esc_seq_url( unsigned char c, char *b )
+{
+    if ( ESC_URL( c ) )
+    {
+        b[0] = '%';
+        b[1] = DTOX(c >> 4);
+        b[2] = DTOX(c);
+        return 3;
+    }
+    b[0] = c;
+    return 1;
+}
+
+size_t str_escape_update( char *buf, size_t sz, const void *s, size_t len, size_t *consumed )
+{
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
+    size_t n = 0, k;
+    char b[4];
+
+    while ( p < end )
+    {
+        if ( end - p >= SWAR_SZ && n + SWAR_SZ <= sz && !ESC_WORD( swar_ld( p ) ) )
+        {
+            memcpy( buf + n, p, SWAR_SZ );
+            n += SWAR_SZ;
+            p += SWAR_SZ;
+            continue;
+        }
+        k = esc_seq_c( *p, b );
+        if ( n + k > sz )
+            break;
+        memcpy( buf + n, b, k );
+        n += k;
+        ++p;
+    }
+    *consumed = p - (const unsigned char *)s;
+    return n;
+}
+
+size_t str_urlencode_update( char *buf, size_t sz, const void *s, size_t len, size_t *consumed )
+{
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
+    size_t n = 0, k;
+    char b[3];
+
+    while ( p < end )
+    {
+        if ( end - p >= SWAR_SZ && n + SWAR_SZ <= sz && !URL_WORD( swar_ld( p ) ) )
+        {
+            memcpy( buf + n, p, SWAR_SZ );
+            n += SWAR_SZ;
+            p += SWAR_SZ;
+            continue;
+        }
+        k = esc_seq_url( *p, b );
+        if ( n + k > sz )
+            break;
+        memcpy( buf + n, b, k );
+        n += k;
+        ++p;
+    }
+    *consumed = p - (const unsigned char *)s;
+    return n;
+}
+
 /* EOF */
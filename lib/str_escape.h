@@ -43,10 +43,14 @@
  **
  ** DESCRIPTION
  **   FUNCTIONS
- **     str_escape(), str_urlencode()  string escaping functions
+ **     str_escape(), str_urlencode(), str_jsonescape()  string escaping functions
+ **
+ **     mem_escape(), mem_urlencode(), mem_jsonescape()  length-delimited escaping functions
+ **
+ **     str_escape_update(), str_urlencode_update()  stream escaping functions
  **
  ** SEE ALSO
- **   str_escape(3), str_urlencode(3)
+ **   str_escape(3), str_urlencode(3), str_jsonescape(3), str_escape_update(3)
  **
  */
 
@@ -61,6 +65,14 @@ extern "C" {
 
 extern size_t str_escape( char *buf, size_t sz, const char *s );
 extern size_t str_urlencode( char *buf, size_t sz, const char *s );
+extern size_t str_jsonescape( char *buf, size_t sz, const char *s, size_t *errcnt );
+
+extern size_t mem_escape( char *buf, size_t sz, const void *s, size_t len );
+extern size_t mem_urlencode( char *buf, size_t sz, const void *s, size_t len );
+extern size_t mem_jsonescape( char *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+
+extern size_t str_escape_update( char *buf, size_t sz, const void *s, size_t len, size_t *consumed );
+extern size_t str_urlencode_update( char *buf, size_t sz, const void *s, size_t len, size_t *consumed );
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,368 @@
+/*
+ * str_escprof.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <str_escprof.h>
+
+#include <inc_priv/baseconv.h>
+
+#ifndef EINVAL
+#define EINVAL  22
+#endif
+
+/* Flags stored in the trig table: character c may introduce ... */
+#define TRIG_SYM    0x01    /* ... a symbolic escape sequence */
+#define TRIG_PCT    0x02    /* ... a "%HH" escape sequence */
+#define TRIG_HEX    0x04    /* ... a "\xHH" escape sequence */
+#define TRIG_OCT    0x08    /* ... a "\ooo" escape sequence */
+
+/* Ordering predicate for the symbolic sequence index. */
+#define SYM_BEFORE(P,A,B) \
+    ( (unsigned char)(P)->seq[A][0] < (unsigned char)(P)->seq[B][0] \
+      || ( (P)->seq[A][0] == (P)->seq[B][0] && (P)->len[A] > (P)->len[B] ) )
+
+
+/*
+ **** str_escprof_init 3
+ **
+ ** NAME
+ **   str_escprof_init, str_escprof_encode, str_escprof_decode - escape strings according to a user defined profile
+ **
+ ** SYNOPSIS
+ **   #include <str_escprof.h>
+ **
+ **   int str_escprof_init(str_escprof_t *prof, const str_escrule_t *rules, size_t n);
+ **
+ **   size_t str_escprof_encode(const str_escprof_t *prof, char *buf, size_t sz, const void *s, size_t len);
+ **   size_t str_escprof_decode(const str_escprof_t *prof, char *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   The str_escprof_init() function compiles the n rules in the array
+ **   pointed to by rules into the lookup tables of the escape profile
+ **   pointed to by prof. Each rule assigns an escape method to all
+ **   characters in the closed interval [lo;hi], where later rules take
+ **   precedence over earlier ones. Characters not covered by any rule
+ **   are copied verbatim. The following escape methods are available:
+ **
+ **     ESCPROF_LIT  copy character verbatim
+ **     ESCPROF_SYM  replace character by the string sym
+ **     ESCPROF_HEX  replace character by a '\\xHH' escape sequence
+ **     ESCPROF_OCT  replace character by a '\\ooo' escape sequence
+ **     ESCPROF_PCT  replace character by a '%HH' escape sequence
+ **
+ **   The sym member of a rule is ignored for all methods but ESCPROF_SYM,
+ **   for which it shall point to a string of at least one and less than
+ **   ESCPROF_SYMMAX characters. The string is copied into the profile.
+ **
+ **   The str_escprof_encode() function copies len bytes from the source
+ **   array s to the destination buf, escaping every character as
+ **   specified by the profile pointed to by prof. At most sz bytes are
+ **   written to buf, which is always null terminated. The objects
+ **   pointed to by buf and s, respectively, shall not overlap.
+ **
+ **   The str_escprof_decode() function performs the reverse operation:
+ **   it copies len bytes from the source array s to the destination
+ **   buf, replacing every escape sequence generated by the profile with
+ **   the original character. Where several symbolic sequences start at
+ **   the same position, the longest one is decoded. Escape introducing
+ **   characters that do not start a valid escape sequence are copied
+ **   verbatim, and counted as errors if the profile would have escaped
+ **   them.
+ **   At most sz bytes are written to buf, which is always null
+ **   terminated. The objects pointed to by buf and s, respectively, are
+ **   allowed to overlap, to allow for in-place conversion.
+ **   If errcnt is not NULL, the number of failed conversions is stored
+ **   in *errcnt.
+ **
+ ** RETURN VALUE
+ **   The str_escprof_init() function returns 0 on success. Otherwise -1
+ **   is returned and errno is set to indicate the error.
+ **
+ **   The str_escprof_encode() and str_escprof_decode() functions return
+ **   the total number of bytes required for the conversion (excluding
+ **   the null byte used to terminate the string). In particular, if the
+ **   returned value is less than sz, there was sufficient space in buf
+ **   and the conversion was successful.
+ **
+ ** ERRORS
+ **   EINVAL  A rule specified an interval with lo greater than hi, an
+ **           unknown escape method, or an unsuitable symbolic sequence.
+ **
+ ** NOTES
+ **   Profiles are typically initialized once and can then be shared
+ **   between any number of threads.
+ **
+ **   The decoder is only guaranteed to reconstruct the original data,
+ **   if the profile escapes the characters that introduce escape
+ **   sequences, i.e. the first character of each symbolic sequence,
+ **   '\\' for ESCPROF_HEX and ESCPROF_OCT, and '%' for ESCPROF_PCT.
+ **
+ **   Profiles operate on individual characters only. Any quoting that
+ **   applies to the string as a whole, as e.g. the enclosing quotation
+ **   marks required for CSV fields or shell words, is left to the caller.
+ **
+ ** EXAMPLE
+ **   The following rules describe the escaping of text for use in HTML
+ **   element content or attribute values:
+ **
+ ** 	static const str_escrule_t html[] = {
+ ** 	    { '&',  '&',  ESCPROF_SYM, "&amp;" },
+ ** 	    { '<',  '<',  ESCPROF_SYM, "&lt;" },
+ ** 	    { '>',  '>',  ESCPROF_SYM, "&gt;" },
+ ** 	    { '"',  '"',  ESCPROF_SYM, "&quot;" },
+ ** 	    { '\\'', '\\'', ESCPROF_SYM, "&#39;" },
+ ** 	};
+ **
+ ** SEE ALSO
+ **   str_escprof_h(3), str_escape(3), str_unescape(3)
+ **
+ */
+
+int str_escprof_init( str_escprof_t *prof, const str_escrule_t *rules, size_t n )
+{
+    unsigned char meth[256];
+    const char *sym[256];
+    size_t i;
+    int c, k, j;
+
+    memset( meth, ESCPROF_LIT, sizeof meth );
+    for ( i = 0; i < n; ++i )
+    {
+        if ( rules[i].lo > rules[i].hi
+            || rules[i].method < ESCPROF_LIT || rules[i].method > ESCPROF_PCT
+            || ( ESCPROF_SYM == rules[i].method && ( !rules[i].sym
+                || !*rules[i].sym || strlen( rules[i].sym ) >= ESCPROF_SYMMAX ) ) )
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        for ( c = rules[i].lo; c <= rules[i].hi; ++c )
+        {
+            meth[c] = rules[i].method;
+            sym[c] = rules[i].sym;
+        }
+    }
+
+    /* Pre-compute the complete escape sequence for each character. */
+    memset( prof, 0, sizeof *prof );
+    for ( c = 0; c < 256; ++c )
+    {
+        char *q = prof->seq[c];
+        switch ( meth[c] )
+        {
+        case ESCPROF_SYM:
+            strcpy( q, sym[c] );
+            prof->trig[(unsigned char)*q] |= TRIG_SYM;
+            break;
+        case ESCPROF_HEX:
+            q[0] = '\\';
+            q[1] = 'x';
+            q[2] = DTOX(c >> 4);
+            q[3] = DTOX(c);
+            prof->trig['\\'] |= TRIG_HEX;
+            break;
+        case ESCPROF_OCT:
+            q[0] = '\\';
+            q[1] = DTOO(c >> 6);
+            q[2] = DTOO(c >> 3);
+            q[3] = DTOO(c);
+            prof->trig['\\'] |= TRIG_OCT;
+            break;
+        case ESCPROF_PCT:
+            q[0] = '%';
+            q[1] = DTOX(c >> 4);
+            q[2] = DTOX(c);
+            prof->trig['%'] |= TRIG_PCT;
+            break;
+        default:
+            break;
+        }
+        prof->len[c] = strlen( q );
+    }
+
+    /* Build the symbolic sequence index used by the decoder: sorted by
+       first character, and longest sequence first. */
+    for ( c = k = 0; c < 256; ++c )
+    {
+        if ( ESCPROF_SYM != meth[c] )
+            continue;
+        for ( j = k++; j > 0 && SYM_BEFORE( prof, c, prof->symord[j-1] ); --j )
+            prof->symord[j] = prof->symord[j-1];
+        prof->symord[j] = c;
+    }
+    for ( c = j = 0; c < 256; ++c )
+    {
+        prof->symoff[c] = j;
+        while ( j < k && (unsigned char)prof->seq[prof->symord[j]][0] == c )
+            ++j;
+    }
+    prof->symoff[256] = j;
+    return 0;
+}
+
+size_t str_escprof_encode( const str_escprof_t *prof, char *buf, size_t sz, const void *s, size_t len )
+{
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
+    const unsigned char *r;
+    size_t n, e, k;
+
+    for ( n = e = 0; p < end; )
+    {
+        /* Copy a run of literal characters in one go. */
+        for ( r = p; r < end && !prof->len[*r]; ++r )
+            ;
+        if ( r > p )
+        {
+            k = r - p;
+            if ( n + k < sz )
+            {
+                memcpy( buf + n, p, k );
+                e = n + k;
+            }
+            else if ( n + 1 < sz )
+            {
+                memcpy( buf + n, p, sz - 1 - n );
+                e = sz - 1;
+            }
+            n += k;
+            p = r;
+            continue;
+        }
+        k = prof->len[*p];
+        if ( n + k < sz )
+        {
+            memcpy( buf + n, prof->seq[*p], k );
+            e = n + k;
+        }
+        n += k;
+        ++p;
+    }
+    if ( sz )
+        buf[e] = '\0';
+    return n;
+}
+
+size_t str_escprof_decode( const str_escprof_t *prof, char *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
+    const unsigned char *r;
+    size_t n = 0, e = 0, err = 0, k, rem;
+    unsigned i;
+    int c, t;
+
+    while ( p < end )
+    {
+        /* Copy a run of characters that cannot start an escape sequence. */
+        for ( r = p; r < end && !prof->trig[*r]; ++r )
+            ;
+        if ( r > p )
+        {
+            k = r - p;
+            if ( n + k < sz )
+            {
+                memmove( buf + n, p, k );
+                e = n + k;
+            }
+            else if ( n + 1 < sz )
+            {
+                memmove( buf + n, p, sz - 1 - n );
+                e = sz - 1;
+            }
+            n += k;
+            p = r;
+            continue;
+        }
+        c = *p;
+        t = prof->trig[c];
+        rem = end - p;
+        k = 0;
+        if ( t & TRIG_SYM )
+        {
+            for ( i = prof->symoff[c]; i < prof->symoff[c + 1]; ++i )
+            {
+                int d = prof->symord[i];
+                if ( prof->len[d] <= rem && !memcmp( p, prof->seq[d], prof->len[d] ) )
+                {
+                    c = d;
+                    k = prof->len[d];
+                    break;
+                }
+            }
+        }
+        if ( !k && ( t & TRIG_PCT ) && rem >= 3
+            && 0 <= XTOD( p[1] ) && 0 <= XTOD( p[2] ) )
+        {
+            c = XTOD( p[1] ) << 4 | XTOD( p[2] );
+            k = 3;
+        }
+        if ( !k && ( t & TRIG_HEX ) && rem >= 4 && 'x' == p[1]
+            && 0 <= XTOD( p[2] ) && 0 <= XTOD( p[3] ) )
+        {
+            c = XTOD( p[2] ) << 4 | XTOD( p[3] );
+            k = 4;
+        }
+        if ( !k && ( t & TRIG_OCT ) && rem >= 4 && p[1] >= '0' && p[1] <= '3'
+            && is_odigit( p[2] ) && is_odigit( p[3] ) )
+        {
+            c = OTOD( p[1] ) << 6 | OTOD( p[2] ) << 3 | OTOD( p[3] );
+            k = 4;
+        }
+        if ( !k )
+        {
+            /* Not a valid escape sequence, take character literally. */
+            if ( prof->len[c] )
+                ++err;
+            k = 1;
+        }
+        if ( n + 1 < sz )
+        {
+            buf[n] = c;
+            e = n + 1;
+        }
+        ++n;
+        p += k;
+    }
+    if ( sz )
+        buf[e] = '\0';
+    if ( errcnt )
+        *errcnt = err;
+    return n;
+}
+
+/* EOF */
@@ -0,0 +1,115 @@
+/*
+ * str_escprof.h
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ **** str_escprof_h 3
+ **
+ ** NAME
+ **   str_escprof - table driven string escaping with user defined profiles
+ **
+ ** SYNOPSIS
+ **   #include <str_escprof.h>
+ **
+ ** DESCRIPTION
+ **   TYPES
+ **     str_escrule_t  structure type to describe how to escape a range of characters
+ **
+ **     str_escprof_t  structure type holding the lookup tables compiled from a set of rules
+ **
+ **   MACROS
+ **     ESCPROF_LIT, ESCPROF_SYM, ESCPROF_HEX, ESCPROF_OCT, ESCPROF_PCT  escape methods
+ **
+ **     ESCPROF_SYMMAX  maximum length of a symbolic escape sequence, including the null terminator
+ **
+ **   FUNCTIONS
+ **     str_escprof_init()  compile a set of rules into an escape profile
+ **
+ **     str_escprof_encode(), str_escprof_decode()  escape and unescape strings according to an escape profile
+ **
+ ** SEE ALSO
+ **   str_escprof_init(3), str_escape(3), str_unescape(3)
+ **
+ */
+
+#ifndef STR_ESCPROF_H_INCLUDED
+#define STR_ESCPROF_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#define ESCPROF_LIT     0   /* copy verbatim */
+#define ESCPROF_SYM     1   /* replace by user defined sequence */
+#define ESCPROF_HEX     2   /* \xHH */
+#define ESCPROF_OCT     3   /* \ooo */
+#define ESCPROF_PCT     4   /* %HH */
+
+#define ESCPROF_SYMMAX  8
+
+struct str_escrule_t_struct {
+    unsigned char lo, hi;
+    int method;
+    const char *sym;
+};
+
+typedef
+    struct str_escrule_t_struct
+    str_escrule_t;
+
+struct str_escprof_t_struct {
+    unsigned char len[256];
+    char seq[256][ESCPROF_SYMMAX];
+    unsigned char trig[256];
+    unsigned char symord[256];
+    unsigned short symoff[257];
+};
+
+typedef
+    struct str_escprof_t_struct
+    str_escprof_t;
+
+extern int str_escprof_init( str_escprof_t *prof, const str_escrule_t *rules, size_t n );
+
+extern size_t str_escprof_encode( const str_escprof_t *prof, char *buf, size_t sz, const void *s, size_t len );
+extern size_t str_escprof_decode( const str_escprof_t *prof, char *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* ndef STR_ESCPROF_H_INCLUDED */
+
+/* EOF */
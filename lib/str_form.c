@@ -0,0 +1,183 @@
+/*
+ * str_form.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include <stddef.h>
+
+#include <str_form.h>
+#include <str_unescape.h>
+
+/* Characters of special significance in form-urlencoded data. */
+#define F_AMP   0x01
+#define F_EQ    0x02
+#define F_PCT   0x04
+#define F_PLUS  0x08
+
+static const unsigned char fcls[256] = {
+    ['&'] = F_AMP, ['='] = F_EQ, ['%'] = F_PCT, ['+'] = F_PLUS,
+};
+
+/* Decode a key or value in place, as far as flags indicate it is
+   necessary at all. Returns the decoded length. */
+static size_t form_decode( char *s, size_t len, int flags, size_t *err )
+{
+    size_t i, e = 0;
+
+    if ( flags & F_PLUS )
+    {
+        for ( i = 0; i < len; ++i )
+            if ( '+' == s[i] )
+                s[i] = ' ';
+    }
+    /* Every percent sign shortens the data by at least one byte, so
+       the result, including the terminating null byte, always fits. */
+    if ( flags & F_PCT )
+    {
+        len = mem_urldecode( s, len, s, len, &e );
+        *err += e;
+    }
+    return len;
+}
+
+
+/*
+ **** str_form_next 3
+ **
+ ** NAME
+ **   str_form_next - extract the next key/value pair from form-urlencoded data
+ **
+ ** SYNOPSIS
+ **   #include <str_form.h>
+ **
+ **   int str_form_next(char **s, size_t *len, str_form_kv_t *kv, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   The str_form_next() function parses the next field of the
+ **   application/x-www-form-urlencoded data of length *len pointed to by
+ **   *s, as found in URL query strings and HTML form submissions. Fields
+ **   are separated by '&' characters, empty fields are skipped. Key and
+ **   value are separated by the first '=' character in a field; if there
+ **   is none, the value is empty.
+ **
+ **   On return, the members of the object pointed to by kv describe the
+ **   location and length of the decoded key and value, which both lie
+ **   within the parsed data. No data is copied: only keys and values
+ **   containing '+' or '%' characters are decoded in place, by replacing
+ **   each '+' with a space and then applying the percent-decoding of
+ **   str_urldecode(3). Keys and values are not null terminated.
+ **
+ **   Afterwards *s and *len are advanced past the parsed field, so that
+ **   repeated calls iterate over all fields in the data.
+ **
+ **   If errcnt is not NULL, the number of malformed percent-encoded
+ **   sequences in the parsed field is stored in *errcnt.
+ **
+ ** RETURN VALUE
+ **   The str_form_next() function returns 1, if a field was parsed,
+ **   or 0 if the end of the data was reached.
+ **
+ ** NOTES
+ **   The data is modified in the process and must be writable. The
+ **   decoded keys and values remain valid until the data is modified
+ **   or released by the caller.
+ **
+ ** EXAMPLE
+ **   Print all key/value pairs from a query string:
+ **
+ **     char qs[] = "q=caf%C3%A9+au+lait&lang=fr&&flag";
+ **     char *s = qs;
+ **     size_t len = strlen(qs);
+ **     str_form_kv_t kv;
+ **
+ **     while ( str_form_next( &s, &len, &kv, NULL ) )
+ **         printf( "%.*s: %.*s\\n", (int)kv.klen, kv.key, (int)kv.vlen, kv.val );
+ **
+ ** SEE ALSO
+ **   str_urldecode(3)
+ **
+ */
+
+int str_form_next( char **s, size_t *len, str_form_kv_t *kv, size_t *errcnt )
+{
+    char *p = *s;
+    char *end = p + *len;
+    char *eq = NULL;
+    int f, fl[2] = { 0, 0 };
+    size_t err = 0;
+
+    while ( p < end && '&' == *p )
+        ++p;
+    if ( p == end )
+    {
+        *s = p;
+        *len = 0;
+        if ( errcnt )
+            *errcnt = 0;
+        return 0;
+    }
+    /* Single scan to locate the field boundaries and to learn which
+       parts of the field need decoding at all. */
+    kv->key = p;
+    for ( ; p < end; ++p )
+    {
+        if ( 0 == ( f = fcls[(unsigned char)*p] ) )
+            continue;
+        if ( F_AMP == f )
+            break;
+        if ( F_EQ == f && !eq )
+            eq = p;
+        else
+            fl[!!eq] |= f;
+    }
+    if ( eq )
+    {
+        kv->klen = eq - kv->key;
+        kv->val = eq + 1;
+        kv->vlen = p - kv->val;
+    }
+    else
+    {
+        kv->klen = p - kv->key;
+        kv->val = p;
+        kv->vlen = 0;
+    }
+    kv->klen = form_decode( kv->key, kv->klen, fl[0], &err );
+    kv->vlen = form_decode( kv->val, kv->vlen, fl[1], &err );
+    *s = p < end ? p + 1 : p;
+    *len = end - *s;
+    if ( errcnt )
+        *errcnt = err;
+    return 1;
+}
+
+/* EOF */
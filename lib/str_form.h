@@ -0,0 +1,84 @@
+/*
+ * str_form.h
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ **** str_form_h 3
+ **
+ ** NAME
+ **   str_form - parse application/x-www-form-urlencoded data
+ **
+ ** SYNOPSIS
+ **   #include <str_form.h>
+ **
+ ** DESCRIPTION
+ **   TYPES
+ **     str_form_kv_t  structure type describing a key/value pair
+ **
+ **   FUNCTIONS
+ **     str_form_next()  extract the next key/value pair from a form-urlencoded buffer
+ **
+ ** SEE ALSO
+ **   str_form_next(3), str_urldecode(3)
+ **
+ */
+
+#ifndef STR_FORM_H_INCLUDED
+#define STR_FORM_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+struct str_form_kv_t_struct {
+    char *key;
+    size_t klen;
+    char *val;
+    size_t vlen;
+};
+
+typedef
+    struct str_form_kv_t_struct
+    str_form_kv_t;
+
+extern int str_form_next( char **s, size_t *len, str_form_kv_t *kv, size_t *errcnt );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* ndef STR_FORM_H_INCLUDED */
+
+/* EOF */
@@ -82,12 +82,11 @@ ISO/IEC 9899:201x N1570 p67 defines these escape-sequences:
 */
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
-#include <str_escape.h>
+#include <str_unescape.h>
 
-#include <inc_priv/baseconv.h>
-
-#define ST_REJ    -1
 #define ST_ACC     0
 #define ST_ACC1    1
 #define ST_ESC     2
@@ -96,103 +95,272 @@ ISO/IEC 9899:201x N1570 p67 defines these escape-sequences:
 #define ST_HEX0    5
 #define ST_HEX1    6
 #define ST_HEXN    7
+#define ST_NUM     8
+
+/*
+ * Byte classes, used to index the decoder transition tables.
+ */
+#define CL_OTH  0   /* any other byte */
+#define CL_BSL  1   /* backslash */
+#define CL_PCT  2   /* percent sign */
+#define CL_X    3   /* 'x' */
+#define CL_OCT  4   /* octal digits */
+#define CL_HEX  5   /* remaining hexadecimal digits */
+#define CL_HSY  6   /* hex digits that double as simple escapes: 'a' 'b' 'f' */
+#define CL_SYM  7   /* remaining simple escape characters */
+#define CL_NUM  8
+
+#define CLM(cl)  ( 1U << (cl) )
+#define CLM_HEX  ( CLM( CL_OCT ) | CLM( CL_HEX ) | CLM( CL_HSY ) )
+#define CLM_SYM  ( CLM( CL_BSL ) | CLM( CL_HSY ) | CLM( CL_SYM ) )
+
+static const uint8_t ucls[256] = {
+    ['\\'] = CL_BSL, ['%'] = CL_PCT, ['x'] = CL_X,
+    ['0'] = CL_OCT, ['1'] = CL_OCT, ['2'] = CL_OCT, ['3'] = CL_OCT,
+    ['4'] = CL_OCT, ['5'] = CL_OCT, ['6'] = CL_OCT, ['7'] = CL_OCT,
+    ['8'] = CL_HEX, ['9'] = CL_HEX,
+    ['c'] = CL_HEX, ['d'] = CL_HEX, ['e'] = CL_HEX,
+    ['A'] = CL_HEX, ['B'] = CL_HEX, ['C'] = CL_HEX,
+    ['D'] = CL_HEX, ['E'] = CL_HEX, ['F'] = CL_HEX,
+    ['a'] = CL_HSY, ['b'] = CL_HSY, ['f'] = CL_HSY,
+    ['\''] = CL_SYM, ['"'] = CL_SYM, ['?'] = CL_SYM,
+    ['n'] = CL_SYM, ['r'] = CL_SYM, ['t'] = CL_SYM, ['v'] = CL_SYM,
+};
+
+/* Replacement characters for simple escape sequences, and digit values. */
+static const uint8_t uval[2][256] = {
+    {
+        ['\''] = '\'', ['"'] = '"', ['?'] = '?', ['\\'] = '\\',
+        ['a'] = '\a', ['b'] = '\b', ['f'] = '\f', ['n'] = '\n',
+        ['r'] = '\r', ['t'] = '\t', ['v'] = '\v',
+    },
+    {
+        ['0'] = 0, ['1'] = 1, ['2'] = 2, ['3'] = 3, ['4'] = 4,
+        ['5'] = 5, ['6'] = 6, ['7'] = 7, ['8'] = 8, ['9'] = 9,
+        ['a'] = 10, ['b'] = 11, ['c'] = 12, ['d'] = 13, ['e'] = 14, ['f'] = 15,
+        ['A'] = 10, ['B'] = 11, ['C'] = 12, ['D'] = 13, ['E'] = 14, ['F'] = 15,
+    },
+};
 
-static inline int unesc( unsigned char b, int st, char *cp )
+/*
+ * Transition table entries combine the next state (low nibble) with
+ * the action to perform on the pending character c (high nibble).
+ */
+#define A_NOP   0x00    /* no change */
+#define A_LIT   0x10    /* c = byte */
+#define A_SYM   0x20    /* c = simple escape replacement */
+#define A_DIG   0x30    /* c = digit value */
+#define A_OCT   0x40    /* c = c * 8 + digit value */
+#define A_HEX   0x50    /* c = c * 16 + digit value */
+#define A_REJ   0x60    /* c = byte, conversion failed */
+
+#define LIT_ACC   ( A_LIT | ST_ACC )
+#define REJ_ACC   ( A_REJ | ST_ACC )
+#define NOP_ACC1  ( A_NOP | ST_ACC1 )
+
+static const uint8_t unesc_t[ST_NUM][CL_NUM] = {
+    /*           OTH       BSL                 PCT       X                 OCT                 HEX                 HSY                 SYM */
+    /* ACC  */ { LIT_ACC,  A_NOP|ST_ESC,       LIT_ACC,  LIT_ACC,          LIT_ACC,            LIT_ACC,            LIT_ACC,            LIT_ACC },
+    /* ACC1 */ { LIT_ACC,  A_NOP|ST_ESC,       LIT_ACC,  LIT_ACC,          LIT_ACC,            LIT_ACC,            LIT_ACC,            LIT_ACC },
+    /* ESC  */ { REJ_ACC,  A_SYM|ST_ACC,       REJ_ACC,  A_NOP|ST_HEX0,    A_DIG|ST_OCT1,      REJ_ACC,            A_SYM|ST_ACC,       A_SYM|ST_ACC },
+    /* OCT1 */ { NOP_ACC1, NOP_ACC1,           NOP_ACC1, NOP_ACC1,         A_OCT|ST_OCT2,      NOP_ACC1,           NOP_ACC1,           NOP_ACC1 },
+    /* OCT2 */ { NOP_ACC1, NOP_ACC1,           NOP_ACC1, NOP_ACC1,         A_OCT|ST_ACC,       NOP_ACC1,           NOP_ACC1,           NOP_ACC1 },
+    /* HEX0 */ { REJ_ACC,  REJ_ACC,            REJ_ACC,  REJ_ACC,          A_DIG|ST_HEXN,      A_DIG|ST_HEXN,      A_DIG|ST_HEXN,      REJ_ACC },
+    /* HEX1 */ { REJ_ACC,  REJ_ACC,            REJ_ACC,  REJ_ACC,          REJ_ACC,            REJ_ACC,            REJ_ACC,            REJ_ACC },
+    /* HEXN */ { NOP_ACC1, NOP_ACC1,           NOP_ACC1, NOP_ACC1,         A_HEX|ST_HEXN,      A_HEX|ST_HEXN,      A_HEX|ST_HEXN,      NOP_ACC1 },
+};
+
+static const uint8_t urldec_t[ST_NUM][CL_NUM] = {
+    /*           OTH       BSL       PCT                 X         OCT                 HEX                 HSY                 SYM */
+    /* ACC  */ { LIT_ACC,  LIT_ACC,  A_NOP|ST_HEX0,      LIT_ACC,  LIT_ACC,            LIT_ACC,            LIT_ACC,            LIT_ACC },
+    /* ACC1 */ { LIT_ACC,  LIT_ACC,  A_NOP|ST_HEX0,      LIT_ACC,  LIT_ACC,            LIT_ACC,            LIT_ACC,            LIT_ACC },
+    /* ESC  */ { REJ_ACC,  REJ_ACC,  REJ_ACC,            REJ_ACC,  REJ_ACC,            REJ_ACC,            REJ_ACC,            REJ_ACC },
+    /* OCT1 */ { REJ_ACC,  REJ_ACC,  REJ_ACC,            REJ_ACC,  REJ_ACC,            REJ_ACC,            REJ_ACC,            REJ_ACC },
+    /* OCT2 */ { REJ_ACC,  REJ_ACC,  REJ_ACC,            REJ_ACC,  REJ_ACC,            REJ_ACC,            REJ_ACC,            REJ_ACC },
+    /* HEX0 */ { REJ_ACC,  REJ_ACC,  REJ_ACC,            REJ_ACC,  A_DIG|ST_HEX1,      A_DIG|ST_HEX1,      A_DIG|ST_HEX1,      REJ_ACC },
+    /* HEX1 */ { REJ_ACC,  REJ_ACC,  REJ_ACC,            REJ_ACC,  A_HEX|ST_ACC,       A_HEX|ST_ACC,       A_HEX|ST_ACC,       REJ_ACC },
+    /* HEXN */ { REJ_ACC,  REJ_ACC,  REJ_ACC,            REJ_ACC,  REJ_ACC,            REJ_ACC,            REJ_ACC,            REJ_ACC },
+};
+
+/*
+ * Perform a single transition of decoder table tt on byte b, updating
+ * the pending character *cp. Returns the table entry, use UDEC_ST() to
+ * obtain the new state, and UDEC_REJ() to test whether b caused the
+ * conversion to fail. The pending character is complete, if the new
+ * state is ST_ACC or ST_ACC1; the latter furthermore indicates that b
+ * has not been consumed and must be fed in again.
+ */
+static inline int udec( const uint8_t (*tt)[CL_NUM], unsigned char b, int st, char *cp )
 {
-    int d;
+    int t = tt[st][ucls[b]];
 
-    switch ( st )
+    switch ( t & 0xf0 )
     {
-        case ST_ACC:
-        case ST_ACC1:
-            if ( '\\' == b )
-                return ST_ESC;
-            return *cp = b, ST_ACC;
-            break;
-        case ST_ESC:
-            if ( 'x' == b )
-                return ST_HEX0;
-            if ( 0 <= ( d = OTOD( b ) ) )
-                return *cp = d, ST_OCT1;
-            switch ( b )
-            {
-            case '\'': *cp = '\''; break;
-            case '"':  *cp = '"';  break;
-            case '?':  *cp = '?';  break;
-            case '\\': *cp = '\\'; break;
-            case 'a':  *cp = '\a'; break;
-            case 'b':  *cp = '\b'; break;
-            case 'f':  *cp = '\f'; break;
-            case 'n':  *cp = '\n'; break;
-            case 'r':  *cp = '\r'; break;
-            case 't':  *cp = '\t'; break;
-            case 'v':  *cp = '\v'; break;
-            default:
-                return *cp = b, ST_REJ;
-                break;
-            }
-            return ST_ACC;
-            break;
-        case ST_HEX0:
-            if ( 0 <= ( d = XTOD( b ) ) )
-                return *cp = d, ST_HEXN;
-            return *cp = b, ST_REJ;
-            break;
-        case ST_HEXN:
-            if ( 0 <= ( d = XTOD( b ) ) )
-                return *cp = (*cp << 4) | d, ST_HEXN;
-            return ST_ACC1;
-            break;
-        case ST_OCT1:
-            if ( 0 <= ( d = OTOD( b ) ) )
-                return *cp = (*cp << 3) | d, ST_OCT2;
-            return ST_ACC1;
-            break;
-        case ST_OCT2:
-            if ( 0 <= ( d = OTOD( b ) ) )
-                return *cp = (*cp << 3) | d, ST_ACC;
-            return ST_ACC1;
-            break;
-        default:
-            break;
+        case A_LIT: *cp = b; break;
+        case A_SYM: *cp = uval[0][b]; break;
+        case A_DIG: *cp = uval[1][b]; break;
+        case A_OCT: *cp = (*cp << 3) | uval[1][b]; break;
+        case A_HEX: *cp = (*cp << 4) | uval[1][b]; break;
+        case A_REJ: *cp = b; break;
+        default: break;
     }
-    return ST_REJ;
+    return t;
 }
 
-static inline int urldec( unsigned char b, int st, char *cp )
+#define UDEC_ST(t)    ( (t) & 0x0f )
+#define UDEC_REJ(t)   ( A_REJ == ( (t) & 0xf0 ) )
+
+/*
+ * Append a run of k literal bytes to buf, observing the same truncation
+ * rules as for single characters. The source may lie within buf, as
+ * long as it does not precede the destination.
+ */
+static inline void urun( char *buf, size_t sz, size_t *pn, size_t *pe, const void *p, size_t k )
 {
-    int d;
+    size_t n = *pn;
 
-    switch ( st )
+    if ( n + 1 < sz )
     {
-        case ST_ACC:
-        case ST_ACC1:
-            if ( '%' == b )
-                return ST_HEX0;
-            return *cp = b, ST_ACC;
-            break;
-        case ST_HEX0:
-            if ( 0 <= ( d = XTOD( b ) ) )
-                return *cp = d, ST_HEX1;
-            return *cp = b, ST_REJ;
-            break;
-        case ST_HEX1:
-            if ( 0 <= ( d = XTOD( b ) ) )
-                return *cp = (*cp << 4) | d, ST_ACC;
-            return *cp = b, ST_REJ;
+        size_t m = sz - 1 - n;
+
+        if ( m > k )
+            m = k;
+        if ( buf + n == (const char *)p )
+            *pe = n + m;
+        else if ( m < 16 )
+        {
+            /* Not worth a library call, and safe for overlap. */
+            const char *src = p;
+            char *dst = buf + n;
+
+            while ( m-- )
+                *dst++ = *src++;
+            *pe = dst - buf;
+        }
+        else
+        {
+            memmove( buf + n, p, m );
+            *pe = n + m;
+        }
+    }
+    *pn = n + k;
+}
+
+/* Append a single character to buf. */
+static inline void uput( char *buf, size_t sz, size_t *pn, size_t *pe, char c )
+{
+    if ( *pn + 1 < sz )
+    {
+        buf[*pn] = c;
+        *pe = *pn + 1;
+    }
+    ++*pn;
+}
+
+/*
+ * Decode the complete escape sequence starting at p without running the
+ * automaton, for the most common forms: simple escapes, three digit
+ * octal escapes, and two digit percent-encoded octets. The byte classes
+ * are looked up independently, so there is no serial dependency on the
+ * state. Returns the length of the sequence, or 0 if the automaton has
+ * to take over.
+ */
+static inline size_t ufast( int intro, const unsigned char *p, const unsigned char *end, char *cp )
+{
+    size_t avail = end - p;
+
+    if ( '%' == intro )
+    {
+        if ( avail > 2 && CLM_HEX & CLM( ucls[p[1]] ) && CLM_HEX & CLM( ucls[p[2]] ) )
+            return *cp = uval[1][p[1]] << 4 | uval[1][p[2]], 3;
+    }
+    else if ( avail > 1 )
+    {
+        if ( CLM_SYM & CLM( ucls[p[1]] ) )
+            return *cp = uval[0][p[1]], 2;
+        if ( avail > 3 && CL_OCT == ucls[p[1]] && CL_OCT == ucls[p[2]] && CL_OCT == ucls[p[3]] )
+            return *cp = uval[1][p[1]] << 6 | uval[1][p[2]] << 3 | uval[1][p[3]], 4;
+    }
+    return 0;
+}
+
+/* One-shot decoding of len bytes from s, using table tt. */
+static inline size_t udec_mem( const uint8_t (*tt)[CL_NUM], int intro,
+                    char *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    char c = '\0';
+    const unsigned char *p = s, *q;
+    const unsigned char *end = p + len;
+    size_t n = 0, e = 0, err = 0, k;
+    int st = ST_ACC, t = 0;
+    /* State after the escape introducing character. */
+    int st0 = UDEC_ST( tt[ST_ACC][ucls[intro]] );
+
+    if ( (const void *)buf == s )
+    {
+        /* In-place conversion: everything up to the first escape
+           sequence is already where it belongs, just skip over it. */
+        q = memchr( p, intro, len );
+        n = q ? (size_t)( q - p ) : len;
+        e = n < sz ? n : sz ? sz - 1 : 0;
+        p += n;
+    }
+    while ( p < end )
+    {
+        /* Copy literal bytes up to the next escape sequence; longer runs
+           are handed to memchr() and copied in one go. */
+        for ( k = 0; p < end && intro != *p; ++p )
+        {
+            if ( ++k > 16 )
+            {
+                q = memchr( p, intro, end - p );
+                q = q ? q : end;
+                urun( buf, sz, &n, &e, p, q - p );
+                p = q;
+                break;
+            }
+            uput( buf, sz, &n, &e, *p );
+        }
+        if ( p == end )
             break;
-        default:
+        if ( 0 != ( k = ufast( intro, p, end, &c ) ) )
+        {
+            uput( buf, sz, &n, &e, c );
+            p += k;
+            continue;
+        }
+        /* Run the automaton until the escape sequence is complete. */
+        st = st0;
+        while ( ++p < end )
+        {
+            t = udec( tt, *p, st, &c );
+            if ( ST_ACC1 >= ( st = UDEC_ST( t ) ) )
+                break;
+        }
+        if ( p == end )
             break;
+        err += UDEC_REJ( t );
+        uput( buf, sz, &n, &e, c );
+        if ( ST_ACC == st )
+            ++p;
+        st = ST_ACC;
     }
-    return ST_REJ;
+    /* Handle dangling conversions. */
+    if ( ST_HEXN == st || ST_OCT1 == st || ST_OCT2 == st )
+        uput( buf, sz, &n, &e, c );
+    else if ( ST_ESC == st || ST_HEX0 == st || ST_HEX1 == st )
+        ++err;
+    buf[e] = '\0';
+    if ( errcnt )
+        *errcnt = err;
+    return n;
 }
 
-
 /*
  **** str_unescape 3
  **
  ** NAME
- **   str_unescape, str_urldecode - decode escaped or URL encoded strings
+ **   str_unescape, str_urldecode, mem_unescape, mem_urldecode - decode escaped or URL encoded strings
  **
  ** SYNOPSIS
  **   #include <str_unescape.h>
@@ -200,6 +368,9 @@ static inline int urldec( unsigned char b, int st, char *cp )
  **   size_t str_unescape(char *buf, size_t sz, const char *s, size_t *errcnt);
  **   size_t str_urldecode(char *buf, size_t sz, const char *s, size_t *errcnt);
  **
+ **   size_t mem_unescape(char *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **   size_t mem_urldecode(char *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **
  ** DESCRIPTION
  **   The str_unescape() function copies characters from the null
  **   terminated source character array s to the destination buf,
@@ -208,7 +379,10 @@ static inline int urldec( unsigned char b, int st, char *cp )
  **   At most sz bytes are written to buf, which is always null
  **   terminated. The objects pointed to by buf and s, respectively,
  **   are allowed to overlap, to allow for in-place conversion of
- **   mutable strings.
+ **   mutable strings. If buf and s are equal, the part of the string
+ **   preceding the first escape sequence is not written, so that
+ **   in-place conversion of a string without any escape sequences only
+ **   stores the terminating null byte.
  **   If errcnt is not NULL, the number of failed conversions is
  **   stored in *errcnt.
  **
@@ -216,12 +390,17 @@ static inline int urldec( unsigned char b, int st, char *cp )
  **   encoded ("percent-encoded") sequences, according to RFC3986
  **   sect. 2.2.
  **
+ **   The mem_unescape() and mem_urldecode() functions are similar to
+ **   their str_ counterparts, except they inspect exactly len bytes from
+ **   the array s and do not treat null bytes special. The decoded data
+ **   may thus contain embedded null bytes.
+ **
  ** RETURN VALUE
- **   The str_unescape() and str_urldecode() functions return the total
- **   number of bytes required for the conversion (excluding the null
- **   byte used to terminate the string). In particular, if the returned
- **   value is less than sz, there was sufficient space in buf and the
- **   conversion was successful.
+ **   All of these functions return the total number of bytes required
+ **   for the conversion (excluding the null byte used to terminate the
+ **   string). In particular, if the returned value is less than sz,
+ **   there was sufficient space in buf and the conversion was
+ **   successful.
  **
  ** NOTES
  **   It is possible for the str_unescape() function to produce unexpected
@@ -240,90 +419,186 @@ static inline int urldec( unsigned char b, int st, char *cp )
  **
  */
 
+size_t mem_unescape( char *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return udec_mem( unesc_t, '\\', buf, sz, s, len, errcnt );
+}
+
+size_t mem_urldecode( char *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return udec_mem( urldec_t, '%', buf, sz, s, len, errcnt );
+}
+
 size_t str_unescape( char *buf, size_t sz, const char *s, size_t *errcnt )
 {
-    char c = '\0';
-    const char *p = s;
-    size_t n = 0, e = 0, err = 0;
-    int st = ST_ACC;
+    return mem_unescape( buf, sz, s, strlen( s ), errcnt );
+}
+
+size_t str_urldecode( char *buf, size_t sz, const char *s, size_t *errcnt )
+{
+    return mem_urldecode( buf, sz, s, strlen( s ), errcnt );
+}
+
+
+/*
+ **** str_unescape_update 3
+ **
+ ** NAME
+ **   str_unesc_init, str_unescape_update, str_unescape_final, str_urldecode_update, str_urldecode_final - decode escaped or URL encoded data streams
+ **
+ ** SYNOPSIS
+ **   #include <str_unescape.h>
+ **
+ **   void str_unesc_init(str_unesc_ctx_t *ctx);
+ **
+ **   size_t str_unescape_update(str_unesc_ctx_t *ctx, char *buf, size_t sz, const void *s, size_t len, size_t *consumed);
+ **   size_t str_unescape_final(str_unesc_ctx_t *ctx, char *buf, size_t sz, size_t *errcnt);
+ **
+ **   size_t str_urldecode_update(str_unesc_ctx_t *ctx, char *buf, size_t sz, const void *s, size_t len, size_t *consumed);
+ **   size_t str_urldecode_final(str_unesc_ctx_t *ctx, char *buf, size_t sz, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   These functions perform the same conversions as str_unescape(3) and
+ **   str_urldecode(3), respectively, but process the input in chunks of
+ **   arbitrary size, preserving the decoder state in the object pointed
+ **   to by ctx between calls. This allows for data to be decoded as it
+ **   arrives, without first collecting it in a null terminated string.
+ **
+ **   The str_unesc_init() function initializes the decoder context
+ **   pointed to by ctx. Alternatively, a context object can be statically
+ **   initialized with STR_UNESC_CTX_INITIALIZER.
+ **
+ **   The str_unescape_update() function decodes up to len bytes from the
+ **   array s and stores up to sz decoded bytes in buf. Null bytes in s
+ **   are not treated special, and buf is not null terminated. Processing
+ **   stops early when buf is full, the number of bytes taken from s is
+ **   stored in *consumed. The remaining input has to be passed again in
+ **   a subsequent call.
+ **
+ **   The str_unescape_final() function finishes the conversion, i.e.
+ **   it handles any escape sequence left dangling at the end of input.
+ **   It stores at most one byte in buf. If errcnt is not NULL, the total
+ **   number of failed conversions is stored in *errcnt. Afterwards the
+ **   context is ready to be reused for a new conversion.
+ **
+ **   The str_urldecode_update() and str_urldecode_final() functions work
+ **   similar, but decode URL encoded ("percent-encoded") data.
+ **
+ **   The objects pointed to by buf and s, respectively, shall not
+ **   overlap.
+ **
+ ** RETURN VALUE
+ **   All functions except str_unesc_init() return the number of bytes
+ **   stored in buf.
+ **
+ ** NOTES
+ **   A context must not be used with str_unescape_update() and
+ **   str_urldecode_update() alternately without being reinitialized.
+ **
+ **   The str_unescape_final() function requires sz to be at least 1,
+ **   or else a pending conversion is lost. The str_urldecode_final()
+ **   function never stores anything in buf.
+ **
+ ** SEE ALSO
+ **   str_unescape(3), str_urldecode(3), str_escape_update(3)
+ **
+ */
+
+void str_unesc_init( str_unesc_ctx_t *ctx )
+{
+    ctx->st = ST_ACC;
+    ctx->c = '\0';
+    ctx->err = 0;
+}
 
-    while ( *p )
+/* Run one of the decoders on a chunk of input, stop when buf is full. */
+static inline size_t unesc_chunk( str_unesc_ctx_t *ctx, const uint8_t (*tt)[CL_NUM], int intro,
+                    char *buf, size_t sz, const void *s, size_t len, size_t *consumed )
+{
+    const unsigned char *p = s, *q;
+    const unsigned char *end = p + len;
+    size_t n = 0, err = 0, k;
+    int st = ctx->st, nst, t;
+    char c = ctx->c, nc;
+
+    while ( p < end )
     {
-        st = unesc( *p, st, &c );
-        if ( ST_REJ == st )
+        if ( ST_ACC == st && intro != *p )
         {
-            ++err;
-            st = ST_ACC;
-        }
-        if ( ST_ACC == st || ST_ACC1 == st )
-        {
-            if ( n + 1 < sz )
+            /* Copy literal runs in one go, as far as they fit. */
+            k = sz - n;
+            if ( k > (size_t)( end - p ) )
+                k = end - p;
+            if ( NULL != ( q = memchr( p, intro, k ) ) )
+                k = q - p;
+            if ( k )
             {
-                buf[n++] = c;
-                e = n;
-            }
-            else
-                ++n;
-            if ( ST_ACC1 == st )
+                memcpy( buf + n, p, k );
+                n += k;
+                p += k;
                 continue;
+            }
         }
-        ++p;
-    }
-    /* Handle dangling conversions. */
-    if ( ST_HEXN == st || ST_OCT1 == st || ST_OCT2 == st )
-    {
-        if ( n + 1 < sz )
+        /* Only commit the state transition, if the output fits. */
+        nc = c;
+        t = udec( tt, *p, st, &nc );
+        nst = UDEC_ST( t );
+        if ( ST_ACC1 >= nst )
         {
-            buf[n++] = c;
-            e = n;
+            if ( n >= sz )
+                break;
+            buf[n++] = nc;
         }
-        else
-            ++n;
+        err += UDEC_REJ( t );
+        st = nst;
+        c = nc;
+        if ( ST_ACC1 != st )
+            ++p;
     }
-    else if ( ST_ESC == st || ST_HEX0 == st )
-        ++err;
-    buf[e] = '\0';
-    if ( errcnt )
-        *errcnt = err;
+    ctx->st = st;
+    ctx->c = c;
+    ctx->err += err;
+    *consumed = p - (const unsigned char *)s;
     return n;
 }
 
-size_t str_urldecode( char *buf, size_t sz, const char *s, size_t *errcnt )
+size_t str_unescape_update( str_unesc_ctx_t *ctx, char *buf, size_t sz, const void *s, size_t len, size_t *consumed )
 {
-    char c = '\0';
-    const char *p = s;
-    size_t n = 0, e = 0, err = 0;
-    int st = ST_ACC;
+    return unesc_chunk( ctx, unesc_t, '\\', buf, sz, s, len, consumed );
+}
 
-    while ( *p )
+size_t str_unescape_final( str_unesc_ctx_t *ctx, char *buf, size_t sz, size_t *errcnt )
+{
+    size_t n = 0;
+
+    if ( ST_HEXN == ctx->st || ST_OCT1 == ctx->st || ST_OCT2 == ctx->st )
     {
-        st = urldec( *p, st, &c );
-        if ( ST_REJ == st )
-        {
-            ++err;
-            st = ST_ACC;
-        }
-        if ( ST_ACC == st || ST_ACC1 == st )
-        {
-            if ( n + 1 < sz )
-            {
-                buf[n++] = c;
-                e = n;
-            }
-            else
-                ++n;
-            if ( ST_ACC1 == st )
-                continue;
-        }
-        ++p;
+        if ( sz )
+            buf[n++] = ctx->c;
     }
-    /* Handle dangling conversions. */
-    if ( ST_ESC == st || ST_HEX0 == st || ST_HEX1 == st )
-        ++err;
-    buf[e] = '\0';
+    else if ( ST_ESC == ctx->st || ST_HEX0 == ctx->st )
+        ++ctx->err;
     if ( errcnt )
-        *errcnt = err;
+        *errcnt = ctx->err;
+    str_unesc_init( ctx );
     return n;
 }
 
+size_t str_urldecode_update( str_unesc_ctx_t *ctx, char *buf, size_t sz, const void *s, size_t len, size_t *consumed )
+{
+    return unesc_chunk( ctx, urldec_t, '%', buf, sz, s, len, consumed );
+}
+
+size_t str_urldecode_final( str_unesc_ctx_t *ctx, char *buf, size_t sz, size_t *errcnt )
+{
+    (void)buf;
+    (void)sz;
+    if ( ST_HEX0 == ctx->st || ST_HEX1 == ctx->st )
+        ++ctx->err;
+    if ( errcnt )
+        *errcnt = ctx->err;
+    str_unesc_init( ctx );
+    return 0;
+}
+
 /* EOF */
@@ -42,11 +42,21 @@
  **   #include <str_unescape.h>
  **
  ** DESCRIPTION
+ **   TYPES
+ **     str_unesc_ctx_t  structure type to hold the state of a stream decoder
+ **
+ **   MACROS
+ **     STR_UNESC_CTX_INITIALIZER  evaluates to an expression suitable to initialize static objects of type str_unesc_ctx_t
+ **
  **   FUNCTIONS
- **     str_uncescape(), str_urldecode()  string unescaping functions
+ **     str_unescape(), str_urldecode()  string unescaping functions
+ **
+ **     mem_unescape(), mem_urldecode()  length-delimited unescaping functions
+ **
+ **     str_unesc_init(), str_unescape_update(), str_unescape_final(), str_urldecode_update(), str_urldecode_final()  stream unescaping functions
  **
  ** SEE ALSO
- **   str_unescape(3), str_urldecode(3)
+ **   str_unescape(3), str_urldecode(3), str_unescape_update(3)
  **
  */
 
@@ -62,6 +72,29 @@ extern "C" {
 extern size_t str_unescape( char *buf, size_t sz, const char *s, size_t *errcnt );
 extern size_t str_urldecode( char *buf, size_t sz, const char *s, size_t *errcnt );
 
+extern size_t mem_unescape( char *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+extern size_t mem_urldecode( char *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+
+#define STR_UNESC_CTX_INITIALIZER  { 0, '\0', 0 }
+
+struct str_unesc_ctx_t_struct {
+    int st;
+    char c;
+    size_t err;
+};
+
+typedef
+    struct str_unesc_ctx_t_struct
+    str_unesc_ctx_t;
+
+extern void str_unesc_init( str_unesc_ctx_t *ctx );
+
+extern size_t str_unescape_update( str_unesc_ctx_t *ctx, char *buf, size_t sz, const void *s, size_t len, size_t *consumed );
+extern size_t str_unescape_final( str_unesc_ctx_t *ctx, char *buf, size_t sz, size_t *errcnt );
+
+extern size_t str_urldecode_update( str_unesc_ctx_t *ctx, char *buf, size_t sz, const void *s, size_t len, size_t *consumed );
+extern size_t str_urldecode_final( str_unesc_ctx_t *ctx, char *buf, size_t sz, size_t *errcnt );
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
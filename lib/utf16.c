@@ -0,0 +1,347 @@
+/*
+ * utf16.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <utf16.h>
+
+#include "inc_priv/swar.h"
+#include "inc_priv/utf8_indec.h"
+#include "inc_priv/utf8_inenc.h"
+#include "inc_priv/utf8_valid.h"
+
+
+/*
+ * Output is only ever stored in whole code points: once a code point
+ * does not fit in buf, *lim is lowered to stop storing altogether, while
+ * the required size is still accounted for in *n.
+ */
+
+/* Nonzero on big endian hosts, evaluated at compile time in practice. */
+static inline int host_be( void )
+{
+    const uint16_t one = 1;
+    unsigned char c;
+
+    memcpy( &c, &one, 1 );
+    return !c;
+}
+
+/* Load a code unit, in big endian byte order if be is set. */
+static inline unsigned u16_ld( const unsigned char *s, int be )
+{
+    return (unsigned)s[!be] << 8 | s[be];
+}
+
+/* Store a code unit in host byte order. */
+static inline void u16_st( unsigned char *d, uint16_t u )
+{
+    memcpy( d, &u, sizeof u );
+}
+
+/* Swap the bytes of n / 2 code units at d. */
+static void u16_swap( unsigned char *d, size_t n )
+{
+    unsigned char t;
+    size_t i;
+
+    for ( i = 0; i + 1 < n; i += 2 )
+    {
+        t = d[i];
+        d[i] = d[i + 1];
+        d[i + 1] = t;
+    }
+}
+
+/* Append a code point as UTF-16 in host byte order. The limit is lowered
+   to the end of the last code point that fit, and never raised again. */
+static inline void u16_put( unsigned char *buf, size_t *n, size_t *lim, uint32_t cp )
+{
+    size_t k = cp < 0x10000 ? 2 : 4;
+
+    if ( *n + 4 > *lim && *n + k > *lim )
+    {
+        if ( *n < *lim )
+            *lim = *n;
+    }
+    else if ( 2 == k )
+        u16_st( buf + *n, cp );
+    else
+    {
+        cp -= 0x10000;
+        u16_st( buf + *n, 0xd800 | cp >> 10 );
+        u16_st( buf + *n + 2, 0xdc00 | ( cp & 0x3ff ) );
+    }
+    *n += k;
+}
+
+/* Widen a word of ASCII characters to UTF-16 in host byte order. */
+static inline void u16_widen( unsigned char *d, const unsigned char *s )
+{
+    unsigned char a[SWAR_SZ];
+    uint16_t w[SWAR_SZ];
+    size_t i;
+
+    /* The local copies allow the compiler to use vector instructions. */
+    memcpy( a, s, SWAR_SZ );
+    for ( i = 0; i < SWAR_SZ; ++i )
+        w[i] = a[i];
+    memcpy( d, w, sizeof w );
+}
+
+/* Append a valid code point as UTF-8, see u16_put() regarding lim. */
+static inline void u8_put( unsigned char *buf, size_t *n, size_t *lim, uint32_t cp )
+{
+    uint8_t b[4];
+    int k;
+
+    if ( *n + 4 <= *lim )
+        k = utf8_ec( cp, buf + *n );
+    else
+    {
+        k = utf8_ec( cp, b );
+        if ( *n + k > *lim )
+        {
+            if ( *n < *lim )
+                *lim = *n;
+        }
+        else
+            memcpy( buf + *n, b, k );
+    }
+    *n += k;
+}
+
+/* Transcode UTF-8 to UTF-16 in host byte order, then fix up the order. */
+static size_t u8to16( unsigned char *buf, size_t sz, const unsigned char *p, size_t len, size_t *errcnt, int be )
+{
+    const unsigned char *end = p + len;
+    int st = UTF8_ACCEPT;
+    size_t n = 0, lim = sz, bad = 0, k;
+    uint32_t cp = 0;
+
+    while ( p < end )
+    {
+        if ( UTF8_ACCEPT == st && *p < 0x80 )
+        {
+            /* Widen ASCII runs word by word. */
+            while ( end - p >= SWAR_SZ && !swar_hashigh( swar_ld( p ) ) )
+            {
+                if ( n + 2 * SWAR_SZ <= lim )
+                {
+                    u16_widen( buf + n, p );
+                    n += 2 * SWAR_SZ;
+                }
+                else
+                    for ( k = 0; k < SWAR_SZ; ++k )
+                        u16_put( buf, &n, &lim, p[k] );
+                p += SWAR_SZ;
+            }
+            while ( p < end && *p < 0x80 )
+                u16_put( buf, &n, &lim, *p++ );
+            continue;
+        }
+        if ( UTF8_ACCEPT == st && 0 != ( k = utf8_seq_decode( p, end - p, &cp ) ) )
+        {
+            do {
+                u16_put( buf, &n, &lim, cp );
+                p += k;
+            } while ( p < end && 0 != ( k = utf8_seq_decode( p, end - p, &cp ) ) );
+            continue;
+        }
+        st = utf8_c( *p++, st, &cp );
+        if ( UTF8_ACCEPT == st )
+        {
+            u16_put( buf, &n, &lim, cp );
+            cp = 0;
+        }
+        else if ( UTF8_REJECT == st )
+        {
+            u16_put( buf, &n, &lim, UTF_REPLACE_CHAR );
+            ++bad;
+            st = UTF8_ACCEPT;
+            cp = 0;
+        }
+    }
+    if ( UTF8_ACCEPT != st )
+    {
+        u16_put( buf, &n, &lim, UTF_REPLACE_CHAR );
+        ++bad;
+    }
+    /* Fix up the byte order of what has been stored. */
+    if ( be != host_be() )
+        u16_swap( buf, n < lim ? n : lim );
+    if ( NULL != errcnt )
+        *errcnt = bad;
+    return n;
+}
+
+static inline size_t u16to8( unsigned char *buf, size_t sz, const unsigned char *p, size_t len, size_t *errcnt, int be )
+{
+    /* Bits that must be clear in four ASCII code units. */
+    static const unsigned char am[2][SWAR_SZ] = {
+        { 0x80, 0xff, 0x80, 0xff, 0x80, 0xff, 0x80, 0xff },
+        { 0xff, 0x80, 0xff, 0x80, 0xff, 0x80, 0xff, 0x80 },
+    };
+    const uint64_t m = swar_ld( am[be] );
+    const unsigned char *end = p + len;
+    size_t n = 0, lim = sz, bad = 0, i;
+    unsigned u, v;
+    uint32_t cp;
+
+    while ( end - p >= 2 )
+    {
+        if ( 0 == p[!be] && p[be] < 0x80 )
+        {
+            /* Narrow ASCII runs four code units at a time. */
+            while ( end - p >= SWAR_SZ && 0 == ( swar_ld( p ) & m ) )
+            {
+                for ( i = 0; i < SWAR_SZ / 2 && n + i < lim; ++i )
+                    buf[n + i] = p[2 * i + be];
+                n += SWAR_SZ / 2;
+                p += SWAR_SZ;
+            }
+            if ( end - p < 2 )
+                break;
+        }
+        u = u16_ld( p, be );
+        p += 2;
+        cp = u;
+        if ( u - 0xd800 < 0x800 )
+        {
+            /* Surrogate: combine a well formed pair, reject all else. */
+            if ( u < 0xdc00 && end - p >= 2
+                 && ( v = u16_ld( p, be ) ) - 0xdc00 < 0x400 )
+            {
+                cp = 0x10000 + ( ( u - 0xd800 ) << 10 ) + ( v - 0xdc00 );
+                p += 2;
+            }
+            else
+            {
+                cp = UTF_REPLACE_CHAR;
+                ++bad;
+            }
+        }
+        u8_put( buf, &n, &lim, cp );
+    }
+    if ( p < end )
+    {
+        /* Odd trailing byte. */
+        u8_put( buf, &n, &lim, UTF_REPLACE_CHAR );
+        ++bad;
+    }
+    if ( NULL != errcnt )
+        *errcnt = bad;
+    return n;
+}
+
+
+/*
+ **** utf8_to_utf16le 3
+ **
+ ** NAME
+ **   utf8_to_utf16le, utf8_to_utf16be, utf16le_to_utf8, utf16be_to_utf8 - transcode between UTF-8 and UTF-16
+ **
+ ** SYNOPSIS
+ **   #include <utf16.h>
+ **
+ **   size_t utf8_to_utf16le(void *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **   size_t utf8_to_utf16be(void *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **
+ **   size_t utf16le_to_utf8(void *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **   size_t utf16be_to_utf8(void *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   The utf8_to_utf16le() and utf8_to_utf16be() functions transcode
+ **   len bytes of UTF-8 encoded data from the array s to UTF-16 in little
+ **   endian and big endian byte order, respectively, without byte order
+ **   mark. Code points outside the basic multilingual plane are encoded
+ **   as surrogate pairs.
+ **
+ **   The utf16le_to_utf8() and utf16be_to_utf8() functions transcode
+ **   len bytes of UTF-16 encoded data in little endian and big endian
+ **   byte order, respectively, from the array s to UTF-8. A byte order
+ **   mark is not treated special.
+ **
+ **   All functions store at most sz bytes in buf, which is not null
+ **   terminated. The output is truncated at a code point boundary, if
+ **   buf is too small. Null bytes in s are not treated special. For each
+ **   malformed UTF-8 sequence, unpaired UTF-16 surrogate or odd trailing
+ **   byte in the input the replacement character U+FFFD is produced.
+ **   If errcnt is not NULL, the number of replacements is stored in
+ **   *errcnt.
+ **
+ ** RETURN VALUE
+ **   All functions return the total number of bytes required to store
+ **   the complete output. If the return value is greater than sz, the
+ **   output was truncated.
+ **
+ ** NOTES
+ **   Unlike utf8_mem_decode(3), the utf8_to_utf16le() and
+ **   utf8_to_utf16be() functions produce a replacement character for an
+ **   incomplete sequence at the end of input.
+ **
+ **   The objects pointed to by buf and s, respectively, shall not
+ **   overlap.
+ **
+ **   These functions are not affected by the current locale setting.
+ **
+ ** SEE ALSO
+ **   utf16_h(3), utf8_mem_decode(3), utf8_mem_encode(3)
+ **
+ */
+
+size_t utf8_to_utf16le( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return u8to16( buf, sz, s, len, errcnt, 0 );
+}
+
+size_t utf8_to_utf16be( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return u8to16( buf, sz, s, len, errcnt, 1 );
+}
+
+size_t utf16le_to_utf8( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return u16to8( buf, sz, s, len, errcnt, 0 );
+}
+
+size_t utf16be_to_utf8( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return u16to8( buf, sz, s, len, errcnt, 1 );
+}
+
+/* EOF */
@@ -0,0 +1,86 @@
+/*
+ * utf16.h
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ **** utf16_h 3
+ **
+ ** NAME
+ **   utf16 - UTF-8 to and from UTF-16 transcoding functions
+ **
+ ** SYNOPSIS
+ **   #include <utf16.h>
+ **
+ ** DESCRIPTION
+ **
+ **   MACROS
+ **     UTF_REPLACE_CHAR  Unicode code point used as replacement char
+ **
+ **   FUNCTIONS
+ **     utf8_to_utf16le(), utf8_to_utf16be()  transcode UTF-8 to UTF-16
+ **
+ **     utf16le_to_utf8(), utf16be_to_utf8()  transcode UTF-16 to UTF-8
+ **
+ ** SEE ALSO
+ **   utf8_decode_h(3), utf8_encode_h(3)
+ **
+ */
+
+#ifndef UTF16_H_INCLUDED
+#define UTF16_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+
+#undef UTF_REPLACE_CHAR
+#define UTF_REPLACE_CHAR    0xFFFD
+
+
+extern size_t utf8_to_utf16le( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+extern size_t utf8_to_utf16be( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+
+extern size_t utf16le_to_utf8( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+extern size_t utf16be_to_utf8( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif  /* ndef UTF16_H_INCLUDED */
+
+/* EOF */
@@ -34,10 +34,13 @@
 
 
 #include <stddef.h>
+#include <string.h>
 
 #include <utf8_decode.h>
 
+#include "inc_priv/swar.h"
 #include "inc_priv/utf8_indec.h"
+#include "inc_priv/utf8_valid.h"
 
 
 /*
@@ -82,18 +85,16 @@
 
 size_t utf8_str_count( const char *s, size_t *errcnt )
 {
-    const char *p;
-    int st = UTF8_ACCEPT;
+    return utf8_mem_count( (void *)s, strlen( s ), errcnt );
+}
+
+size_t utf8_mem_count( void *s, size_t size, size_t *errcnt )
+{
+    const unsigned char *p = s;
     size_t ok = 0, bad = 0;
+    int st;
 
-    for ( p = s; *p; ++p )
-    {
-        st = utf8_v( (unsigned char)*p, st );
-        if ( UTF8_ACCEPT == st )
-            ++ok;
-        else if ( UTF8_REJECT == st )
-            ++bad, st = UTF8_ACCEPT;
-    }
+    st = utf8_count_run( p, p + size, UTF8_ACCEPT, &ok, &bad );
     if ( UTF8_ACCEPT != st )
         ++bad;
     if ( NULL != errcnt )
@@ -101,25 +102,69 @@ size_t utf8_str_count( const char *s, size_t *errcnt )
     return ok;
 }
 
-size_t utf8_mem_count( void *s, size_t size, size_t *errcnt )
+
+/*
+ **** utf8_mem_count_trusted 3
+ **
+ ** NAME
+ **   utf8_mem_count_trusted - count code points in valid UTF-8 data
+ **
+ ** SYNOPSIS
+ **   #include <utf8_decode.h>
+ **
+ **   size_t utf8_mem_count_trusted(const void *s, size_t size);
+ **
+ ** DESCRIPTION
+ **   The utf8_mem_count_trusted() function counts the code points in the
+ **   first size bytes of the memory area pointed to by s, which must hold
+ **   well formed UTF-8, e.g. because it was validated before. In that case
+ **   the number of code points equals the number of bytes that are not
+ **   continuation bytes, which can be counted many bytes at a time.
+ **
+ ** RETURN VALUE
+ **   The utf8_mem_count_trusted() function returns the number of code
+ **   points.
+ **
+ ** NOTES
+ **   The function does not validate its input. For malformed data the
+ **   result differs from that of utf8_mem_count(3), but is otherwise
+ **   harmless.
+ **
+ ** SEE ALSO
+ **   utf8_mem_count(3)
+ **
+ */
+
+size_t utf8_mem_count_trusted( const void *s, size_t size )
 {
-    const char *p;
-    int st = UTF8_ACCEPT;
-    size_t ok = 0, bad = 0;
+    const unsigned char *p = s;
+    const unsigned char *end = p + size;
+    size_t cont = 0;
+    uint64_t acc;
+    int i;
 
-    for ( p = s; size--; ++p )
+    while ( end - p >= SWAR_SZ )
     {
-        st = utf8_v( (unsigned char)*p, st );
-        if ( UTF8_ACCEPT == st )
-            ++ok;
-        else if ( UTF8_REJECT == st )
-            ++bad, st = UTF8_ACCEPT;
+        /* Sum the flags per byte lane, for up to 255 words; with a
+           constant trip count the compiler vectorizes the loop. */
+        acc = 0;
+        if ( end - p >= 255 * SWAR_SZ )
+        {
+            for ( i = 0; i < 255; ++i )
+                acc += swar_m_cont( swar_ld( p + i * SWAR_SZ ) ) >> 7;
+            p += 255 * SWAR_SZ;
+        }
+        else
+        {
+            for ( ; end - p >= SWAR_SZ; p += SWAR_SZ )
+                acc += swar_m_cont( swar_ld( p ) ) >> 7;
+        }
+        acc = ( acc & UINT64_C(0x00ff00ff00ff00ff) ) + ( ( acc >> 8 ) & UINT64_C(0x00ff00ff00ff00ff) );
+        cont += ( acc * UINT64_C(0x0001000100010001) ) >> 48;
     }
-    if ( UTF8_ACCEPT != st )
-        ++bad;
-    if ( NULL != errcnt )
-        *errcnt = bad;
-    return ok;
+    for ( ; p < end; ++p )
+        cont += 0x80 == ( *p & 0xc0 );
+    return size - cont;
 }
 
 
@@ -159,54 +204,74 @@ size_t utf8_mem_count( void *s, size_t size, size_t *errcnt )
  **   total sum of good and bad sequences is less than or equal to max.
  **
  ** SEE ALSO
- **   utf8_decode_h(3), utf8_str_count(3), utf8_stream_decode(3)
+ **   utf8_decode_h(3), utf8_str_count(3), utf8_stream_decode(3),
+ **   utf8_dec_update(3)
  **
  */
 
+/* Zero-extend a word of ASCII characters into the output buffer. */
+static inline void utf8_widen( uint32_t *d, const unsigned char *s )
+{
+    unsigned char a[SWAR_SZ];
+    size_t i;
+
+    /* The local copy tells the compiler d and s do not overlap. */
+    memcpy( a, s, SWAR_SZ );
+    for ( i = 0; i < SWAR_SZ; ++i )
+        d[i] = a[i];
+}
+
 size_t utf8_str_decode( uint32_t *buf, size_t max, const char *s, size_t *errcnt )
 {
-    const char *p;
+    return utf8_mem_decode( buf, max, (void *)s, strlen( s ), errcnt );
+}
+
+size_t utf8_mem_decode( uint32_t *buf, size_t max, void *s, size_t size, size_t *errcnt )
+{
+    const unsigned char *p = s;
+    const unsigned char *end = p + size;
     int st = UTF8_ACCEPT;
-    size_t cnt = 0, bad = 0;
+    size_t cnt = 0, bad = 0, i, n;
     uint32_t cp = 0;
 
-    for ( p = s; *p; ++p )
+    while ( p < end )
     {
-        st = utf8_c( (unsigned char)*p, st, &cp );
-        if ( UTF8_ACCEPT == st )
+        if ( UTF8_ACCEPT == st && *p < 0x80 )
         {
-            if ( cnt < max )
-                buf[cnt] = cp;
-            ++cnt;
-            cp = 0;
+            /* Widen ASCII runs word by word. */
+            while ( end - p >= SWAR_SZ && !swar_hashigh( swar_ld( p ) ) )
+            {
+                if ( cnt < max && max - cnt >= SWAR_SZ )
+                    utf8_widen( buf + cnt, p );
+                else
+                    for ( i = 0; i < SWAR_SZ && cnt + i < max; ++i )
+                        buf[cnt + i] = p[i];
+                cnt += SWAR_SZ;
+                p += SWAR_SZ;
+            }
+            while ( p < end && *p < 0x80 )
+            {
+                if ( cnt < max )
+                    buf[cnt] = *p;
+                ++cnt;
+                ++p;
+            }
+            continue;
         }
-        else if ( UTF8_REJECT == st )
+        if ( UTF8_ACCEPT == st && 0 != ( n = utf8_seq_decode( p, end - p, &cp ) ) )
         {
-            if ( cnt < max )
-                buf[cnt] = UTF_REPLACE_CHAR;
-            ++cnt;
-            ++bad;
-            st = UTF8_ACCEPT;
+            /* Decode well formed multibyte sequences in one go each,
+               leave all else to the DFA. */
+            do {
+                if ( cnt < max )
+                    buf[cnt] = cp;
+                ++cnt;
+                p += n;
+            } while ( p < end && 0 != ( n = utf8_seq_decode( p, end - p, &cp ) ) );
             cp = 0;
+            continue;
         }
-    }
-    if ( UTF8_ACCEPT != st )
-        ++bad;
-    if ( NULL != errcnt )
-        *errcnt = bad;
-    return cnt - bad;
-}
-
-size_t utf8_mem_decode( uint32_t *buf, size_t max, void *s, size_t size, size_t *errcnt )
-{
-    const char *p;
-    int st = UTF8_ACCEPT;
-    size_t cnt = 0, bad = 0;
-    uint32_t cp = 0;
-
-    for ( p = s; size--; ++p )
-    {
-        st = utf8_c( (unsigned char)*p, st, &cp );
+        st = utf8_c( *p++, st, &cp );
         if ( UTF8_ACCEPT == st )
         {
             if ( cnt < max )
@@ -222,7 +287,7 @@ size_t utf8_mem_decode( uint32_t *buf, size_t max, void *s, size_t size, size_t
             ++bad;
             st = UTF8_ACCEPT;
             cp = 0;
-       }
+        }
     }
     if ( UTF8_ACCEPT != st )
         ++bad;
@@ -299,7 +364,8 @@ size_t utf8_mem_decode( uint32_t *buf, size_t max, void *s, size_t size, size_t
  ** 	}
  **
  ** SEE ALSO
- **   utf8_decode_h(3), utf8_str_count(3), utf8_str_decode(3)
+ **   utf8_decode_h(3), utf8_str_count(3), utf8_str_decode(3),
+ **   utf8_dec_update(3)
  **
  */
 
@@ -337,4 +403,250 @@ size_t utf8_stream_decode( int(*get)(void*), int(*put)(uint32_t,void*), void *us
 }
 
 
+/*
+ **** utf8_dec_update 3
+ **
+ ** NAME
+ **   utf8_dec_init, utf8_dec_update, utf8_dec_final - decode UTF-8 encoded data in chunks
+ **
+ ** SYNOPSIS
+ **   #include <utf8_decode.h>
+ **
+ **   void utf8_dec_init(utf8_dec_ctx_t *ctx);
+ **
+ **   size_t utf8_dec_update(utf8_dec_ctx_t *ctx, uint32_t *buf, size_t max, const void *s, size_t len, size_t *consumed);
+ **
+ **   size_t utf8_dec_final(utf8_dec_ctx_t *ctx, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   These functions perform the same conversion as utf8_mem_decode(3),
+ **   but process the input in chunks of arbitrary size, preserving the
+ **   decoder state in the object pointed to by ctx between calls. Thus
+ **   sequences may be split across chunk boundaries, which allows for
+ **   data to be decoded as it arrives, e.g. from a socket.
+ **
+ **   The utf8_dec_init() function initializes the decoder context
+ **   pointed to by ctx. Alternatively, a context object can be statically
+ **   initialized with UTF8_DEC_CTX_INITIALIZER.
+ **
+ **   The utf8_dec_update() function decodes up to len bytes from the
+ **   array s and stores up to max code points in buf. For each rejected
+ **   sequence the replacement character U+FFFD is produced. Processing
+ **   stops early when buf is full, the number of bytes taken from s is
+ **   stored in *consumed. The remaining input has to be passed again in
+ **   a subsequent call.
+ **
+ **   The utf8_dec_final() function finishes the conversion, i.e. it
+ **   accounts for a sequence left incomplete at the end of input. If
+ **   errcnt is not NULL, the total number of malformed sequences is
+ **   stored in *errcnt. Afterwards the context is ready to be reused for
+ **   a new conversion.
+ **
+ ** RETURN VALUE
+ **   The utf8_dec_update() function returns the number of code points
+ **   stored in buf.
+ **
+ **   The utf8_dec_final() function returns the total number of valid
+ **   UTF-8 encodings found.
+ **
+ ** NOTES
+ **   Like utf8_mem_decode(3), utf8_dec_final() does not produce a
+ **   replacement character for an incomplete trailing sequence.
+ **
+ ** SEE ALSO
+ **   utf8_decode_h(3), utf8_str_decode(3), utf8_stream_decode(3)
+ **
+ */
+
+void utf8_dec_init( utf8_dec_ctx_t *ctx )
+{
+    ctx->st = UTF8_ACCEPT;
+    ctx->cp = 0;
+    ctx->ok = 0;
+    ctx->err = 0;
+}
+
+size_t utf8_dec_update( utf8_dec_ctx_t *ctx, uint32_t *buf, size_t max, const void *s, size_t len, size_t *consumed )
+{
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
+    int st = ctx->st;
+    size_t cnt = 0, bad = 0, n;
+    uint32_t cp = ctx->cp;
+
+    while ( p < end && cnt < max )
+    {
+        if ( UTF8_ACCEPT == st && *p < 0x80 )
+        {
+            /* Widen ASCII runs word by word, as far as they fit. */
+            while ( end - p >= SWAR_SZ && max - cnt >= SWAR_SZ
+                    && !swar_hashigh( swar_ld( p ) ) )
+            {
+                utf8_widen( buf + cnt, p );
+                cnt += SWAR_SZ;
+                p += SWAR_SZ;
+            }
+            while ( p < end && cnt < max && *p < 0x80 )
+                buf[cnt++] = *p++;
+            continue;
+        }
+        if ( UTF8_ACCEPT == st && 0 != ( n = utf8_seq_decode( p, end - p, &cp ) ) )
+        {
+            buf[cnt++] = cp;
+            p += n;
+            continue;
+        }
+        /* Incomplete sequences at the end of a chunk end up here, the
+           DFA state is carried over to the next call. */
+        st = utf8_c( *p++, st, &cp );
+        if ( UTF8_ACCEPT == st )
+        {
+            buf[cnt++] = cp;
+            cp = 0;
+        }
+        else if ( UTF8_REJECT == st )
+        {
+            buf[cnt++] = UTF_REPLACE_CHAR;
+            ++bad;
+            st = UTF8_ACCEPT;
+            cp = 0;
+        }
+    }
+    ctx->st = st;
+    ctx->cp = cp;
+    ctx->ok += cnt - bad;
+    ctx->err += bad;
+    *consumed = p - (const unsigned char *)s;
+    return cnt;
+}
+
+size_t utf8_dec_final( utf8_dec_ctx_t *ctx, size_t *errcnt )
+{
+    size_t ok = ctx->ok;
+
+    if ( UTF8_ACCEPT != ctx->st )
+        ++ctx->err;
+    if ( NULL != errcnt )
+        *errcnt = ctx->err;
+    utf8_dec_init( ctx );
+    return ok;
+}
+
+
+/* Return a pointer to the first byte at or after p that does not belong
+   to a well formed sequence. */
+static const unsigned char *utf8_valid_run( const unsigned char *p, const unsigned char *end )
+{
+    size_t n;
+    uint32_t cp;
+
+    while ( p < end )
+    {
+        if ( *p < 0x80 )
+        {
+            while ( end - p >= SWAR_SZ && !swar_hashigh( swar_ld( p ) ) )
+                p += SWAR_SZ;
+            while ( p < end && *p < 0x80 )
+                ++p;
+            continue;
+        }
+        if ( 0 == ( n = utf8_seq_decode( p, end - p, &cp ) ) )
+            break;
+        p += n;
+    }
+    return p;
+}
+
+/*
+ **** utf8_mem_sanitize 3
+ **
+ ** NAME
+ **   utf8_mem_sanitize - replace malformed sequences in UTF-8 data
+ **
+ ** SYNOPSIS
+ **   #include <utf8_decode.h>
+ **
+ **   size_t utf8_mem_sanitize(void *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   The utf8_mem_sanitize() function copies len bytes of UTF-8 encoded
+ **   data from the array s to buf, replacing each malformed sequence,
+ **   including an incomplete sequence at the end of input, with the UTF-8
+ **   encoding of the replacement character U+FFFD. At most sz bytes are
+ **   stored in buf, which is not null terminated; sequences are never
+ **   truncated. Null bytes in s are not treated special.
+ **
+ **   Runs of well formed sequences are copied verbatim and as a whole.
+ **   Apart from the treatment of an incomplete final sequence, the result
+ **   is the same as that of decoding s with utf8_mem_decode(3) and
+ **   encoding it again with utf8_mem_encode(3), but without the need for
+ **   an intermediate UTF-32 buffer.
+ **
+ **   If errcnt is not NULL, the number of replacements is stored in
+ **   *errcnt.
+ **
+ ** RETURN VALUE
+ **   The utf8_mem_sanitize() function returns the total number of bytes
+ **   required to store the complete output. If the return value is greater
+ **   than sz, the output was truncated.
+ **
+ ** NOTES
+ **   The objects pointed to by buf and s, respectively, shall not
+ **   overlap.
+ **
+ ** SEE ALSO
+ **   utf8_decode_h(3), utf8_mem_count(3), utf8_mem_decode(3)
+ **
+ */
+
+size_t utf8_mem_sanitize( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    static const unsigned char rc[3] = { 0xef, 0xbf, 0xbd };
+    unsigned char *d = buf;
+    const unsigned char *p = s;
+    const unsigned char *end = p + len;
+    const unsigned char *q;
+    size_t n = 0, lim = sz, bad = 0, k;
+    int st;
+
+    while ( p < end )
+    {
+        q = utf8_valid_run( p, end );
+        if ( q > p )
+        {
+            k = q - p;
+            if ( n < lim && k > lim - n )
+            {
+                /* Store as many whole sequences as fit. */
+                k = lim - n;
+                while ( k > 0 && 0x80 == ( p[k] & 0xc0 ) )
+                    --k;
+                memcpy( d + n, p, k );
+                lim = n + k;
+            }
+            else if ( n < lim )
+                memcpy( d + n, p, k );
+            n += q - p;
+            p = q;
+            if ( p == end )
+                break;
+        }
+        /* Let the DFA decide on the extent of the malformed sequence. */
+        st = UTF8_ACCEPT;
+        do
+            st = utf8_v( *p++, st );
+        while ( UTF8_ACCEPT != st && UTF8_REJECT != st && p < end );
+        ++bad;
+        if ( n + sizeof rc <= lim )
+            memcpy( d + n, rc, sizeof rc );
+        else if ( n < lim )
+            lim = n;
+        n += sizeof rc;
+    }
+    if ( NULL != errcnt )
+        *errcnt = bad;
+    return n;
+}
+
+
 /* EOF */
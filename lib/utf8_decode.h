@@ -43,18 +43,28 @@
  **
  ** DESCRIPTION
  **
+ **   TYPES
+ **     utf8_dec_ctx_t  structure type to hold the state of a chunked decoder
+ **
  **   MACROS
  **     UTF_REPLACE_CHAR  Unicode code point used as replacement char
  **
+ **     UTF8_DEC_CTX_INITIALIZER  evaluates to an expression suitable to initialize static objects of type utf8_dec_ctx_t
+ **
  **   FUNCTIONS
  **     utf8_str_count()  count UTF-8 code points in string
  **     utf8_mem_count()  count UTF-8 code points in memory
+ **     utf8_mem_count_trusted()  count code points in valid UTF-8 data
  **
  **     utf8_str_decode()  decode UTF-8 code points from string
  **     utf8_mem_decode()  decode UTF-8 code points from memory
  **
  **     utf8_stream_decode()  call-back driven UTF-8 decoder
  **
+ **     utf8_dec_init(), utf8_dec_update(), utf8_dec_final()  chunked UTF-8 decoder
+ **
+ **     utf8_mem_sanitize()  replace malformed sequences in UTF-8 data
+ **
  ** SEE ALSO
  **   locale(1), locale(7)
  **
@@ -77,12 +87,32 @@ extern "C" {
 
 extern size_t utf8_str_count( const char *s, size_t *errcnt );
 extern size_t utf8_mem_count( void *s, size_t size, size_t *errcnt );
+extern size_t utf8_mem_count_trusted( const void *s, size_t size );
 
 extern size_t utf8_str_decode( uint32_t *buf, size_t max, const char *s, size_t *errcnt );
 extern size_t utf8_mem_decode( uint32_t *buf, size_t max, void *s, size_t size, size_t *errcnt );
 
 extern size_t utf8_stream_decode( int(*get)(void*), int(*put)(uint32_t,void*), void *usr, size_t *errcnt );
 
+#define UTF8_DEC_CTX_INITIALIZER  { 0, 0, 0, 0 }
+
+struct utf8_dec_ctx_t_struct {
+    int st;
+    uint32_t cp;
+    size_t ok;
+    size_t err;
+};
+
+typedef
+    struct utf8_dec_ctx_t_struct
+    utf8_dec_ctx_t;
+
+extern void utf8_dec_init( utf8_dec_ctx_t *ctx );
+extern size_t utf8_dec_update( utf8_dec_ctx_t *ctx, uint32_t *buf, size_t max, const void *s, size_t len, size_t *consumed );
+extern size_t utf8_dec_final( utf8_dec_ctx_t *ctx, size_t *errcnt );
+
+extern size_t utf8_mem_sanitize( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+
 
 #ifdef __cplusplus
 } /* extern "C" { */
@@ -34,12 +34,142 @@
 
 
 #include <stdio.h>
+#include <string.h>
 
 #include <utf8_encode.h>
 
 #include "inc_priv/utf8_inenc.h"
 
 
+/* Narrow eight code points below U+0080 to bytes. The copies to local
+   arrays allow the compiler to turn this into a few vector operations. */
+static inline void utf8_narrow( uint8_t *d, const uint32_t *s )
+{
+    uint32_t w[8];
+    uint8_t t[8];
+    int i;
+
+    memcpy( w, s, sizeof w );
+    for ( i = 0; i < 8; ++i )
+        t[i] = (uint8_t)w[i];
+    memcpy( d, t, sizeof t );
+}
+
+/* Encode code points from s into buf, as far as their encodings fit
+   completely in room bytes. Returns the number of bytes stored, the
+   number of code points taken from s is stored in *used. */
+static size_t utf8_enc_fill( uint8_t *buf, size_t room, const uint32_t *s, size_t size,
+                             size_t *used, size_t *ok, size_t *bad )
+{
+    uint8_t b[5];
+    int i, n, e;
+    size_t good = 0, err = 0, cnt = 0;
+    uint32_t m;
+    const uint32_t *p = s;
+    const uint32_t *end = s + size;
+
+    /* While there is room for eight sequences of any length, encode
+       blocks of eight code points straight into buf, and pure ASCII
+       blocks all at once. */
+    while ( end - p >= 8 && room - cnt >= 32 )
+    {
+        for ( m = 0, i = 0; i < 8; ++i )
+            m |= p[i];
+        if ( m < 0x80 )
+        {
+            utf8_narrow( buf + cnt, p );
+            cnt += 8;
+            good += 8;
+        }
+        else
+        {
+            for ( i = 0; i < 8; ++i )
+            {
+                n = utf8_ec( p[i], buf + cnt );
+                if ( 0 < n )
+                    ++good;
+                else
+                {
+                    ++err;
+                    n = utf8_ec( UTF_REPLACE_CHAR, buf + cnt );
+                }
+                cnt += n;
+            }
+        }
+        p += 8;
+    }
+    for ( ; p < end; ++p )
+    {
+        n = utf8_ec( *p, b );
+        if ( 0 == ( e = n ) )
+            n = utf8_ec( UTF_REPLACE_CHAR, b );
+        if ( room - cnt < (size_t)n )
+            break;
+        if ( 0 < e )
+            ++good;
+        else
+            ++err;
+        for ( i = 0; i < n; ++i )
+            buf[cnt++] = b[i];
+    }
+    *used = p - s;
+    *ok = good;
+    *bad = err;
+    return cnt;
+}
+
+/* Common part of utf8_str_encode() and utf8_mem_encode(): a sequence
+   is only stored, if at least one byte remains in buf. Once one does
+   not fit, the rest is only validated. */
+static size_t utf8_enc_mem( uint8_t *buf, size_t max, const uint32_t *s, size_t size,
+                            size_t *errcnt, int term )
+{
+    size_t end, used, ok, bad, e;
+
+    end = utf8_enc_fill( buf, max ? max - 1 : 0, s, size, &used, &ok, &bad );
+    if ( term )
+        buf[end] = '\0';
+    if ( used < size )
+    {
+        utf8_mem_encoded_len( s + used, size - used, &e );
+        ok += size - used - e;
+        bad += e;
+    }
+    if ( NULL != errcnt )
+        *errcnt = bad;
+    return ok;
+}
+
+/* Add the encoded lengths and the numbers of invalid code points for
+   n code points from s to *len and *bad. The computation is free of
+   branches, and with a constant n can be vectorized by the compiler. */
+static inline void utf8_elen( const uint32_t *s, int n, uint32_t *len, uint32_t *bad )
+{
+    uint32_t c, r, bl = 0, be = 0;
+    int i;
+
+    /* Pure ASCII is quicker to recognize than to measure. */
+    for ( c = 0, i = 0; i < n; ++i )
+        c |= s[i];
+    if ( c < 0x80 )
+    {
+        *len += n;
+        return;
+    }
+    for ( i = 0; i < n; ++i )
+    {
+        c = s[i];
+        /* Surrogates take three bytes like the replacement character,
+           values beyond U+10FFFF take one less than they appear to. */
+        r = c >> 16 > 0x10;
+        bl += 1 + ( 0 != c >> 7 ) + ( 0 != c >> 11 ) + ( 0 != c >> 16 ) - r;
+        be += ( 0 == ( c - 0xd800 ) >> 11 ) | r;
+    }
+    *len += bl;
+    *bad += be;
+}
+
+
 /*
  **** utf8_str_encode 3
  **
@@ -61,8 +191,8 @@
  **   If errcnt is not NULL, utf8_str_encode() stores the number of
  **   malformed sequences detected in *errcnt.
  **   The utf8_mem_encode() function is similar to utf8_str_encode(),
- **   except it inspects exactly size bytes from array s and does not
- **   treat null words special.
+ **   except it inspects exactly size code points from array s and does
+ **   not treat null words special.
  **
  ** RETURN VALUE
  **   The utf8_str_encode() and utf8_mem_encode() functions return the
@@ -82,65 +212,85 @@
 
 size_t utf8_str_encode( uint8_t *buf, size_t max, const uint32_t *s, size_t *errcnt )
 {
-    uint8_t b[5];
-    int n;
-    size_t ok, bad, cnt, end;
-    const uint32_t *p = s;
+    size_t size;
 
-    for ( cnt = end = ok = bad = 0, p = s; *p; ++p )
-    {
-        n = utf8_ec( *p, b );
-        if ( 0 < n )
-            ++ok;
-        else
-        {
-            ++bad;
-            n = utf8_ec( UTF_REPLACE_CHAR, b );
-        }
-        if ( cnt + n < max )
-        {
-            for ( int i = 0; i < n; ++i )
-                buf[cnt++] = b[i];
-            end = cnt;
-        }
-        else
-            cnt += n;
-    }
-    buf[end] = '\0';
-    if ( NULL != errcnt )
-        *errcnt = bad;
-    return ok;
+    for ( size = 0; s[size]; ++size )
+        ;
+    return utf8_enc_mem( buf, max, s, size, errcnt, 1 );
 }
 
 size_t utf8_mem_encode( uint8_t *buf, size_t max, const uint32_t *s, size_t size, size_t *errcnt )
 {
-    uint8_t b[5];
-    int n;
-    size_t ok, bad, cnt, end;
-    const uint32_t *p = s;
+    return utf8_enc_mem( buf, max, s, size, errcnt, 0 );
+}
+
+
+/*
+ **** utf8_str_encoded_len 3
+ **
+ ** NAME
+ **   utf8_str_encoded_len, utf8_mem_encoded_len - compute length of UTF-8 encoding
+ **
+ ** SYNOPSIS
+ **   #include <utf8_encode.h>
+ **
+ **   size_t utf8_str_encoded_len(const uint32_t *s, size_t *errcnt);
+ **   size_t utf8_mem_encoded_len(const uint32_t *s, size_t size, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   The utf8_str_encoded_len() function computes the number of bytes
+ **   utf8_str_encode(3) produces for the null terminated UTF-32 array s,
+ **   not counting the terminating null byte. Invalid code points are
+ **   accounted for by the length of the replacement character U+FFFD.
+ **   If errcnt is not NULL, the number of invalid code points is stored
+ **   in *errcnt.
+ **   The utf8_mem_encoded_len() function is similar, except it inspects
+ **   exactly size code points from array s, like utf8_mem_encode(3).
+ **
+ ** RETURN VALUE
+ **   The utf8_str_encoded_len() and utf8_mem_encoded_len() functions
+ **   return the length of the UTF-8 encoding in bytes.
+ **
+ ** NOTES
+ **   As utf8_str_encode(3) and utf8_mem_encode(3) only store a sequence,
+ **   if there is at least one byte left in the buffer afterwards, the
+ **   buffer size passed to them must exceed the computed length by one.
+ **
+ ** SEE ALSO
+ **   utf8_encode_h(3), utf8_mem_encode(3)
+ **
+ */
 
-    for ( cnt = end = ok = bad = 0, p = s; size--; ++p )
+size_t utf8_str_encoded_len( const uint32_t *s, size_t *errcnt )
+{
+    size_t size;
+
+    for ( size = 0; s[size]; ++size )
+        ;
+    return utf8_mem_encoded_len( s, size, errcnt );
+}
+
+size_t utf8_mem_encoded_len( const uint32_t *s, size_t size, size_t *errcnt )
+{
+    size_t len = 0, bad = 0, i, k;
+    uint32_t bl, be;
+
+    while ( size > 0 )
     {
-        n = utf8_ec( *p, b );
-        if ( 0 < n )
-            ++ok;
-        else
-        {
-            ++bad;
-            n = utf8_ec( UTF_REPLACE_CHAR, b );
-        }
-        if ( cnt + n < max )
-        {
-            for ( int i = 0; i < n; ++i )
-                buf[cnt++] = b[i];
-            end = cnt;
-        }
-        else
-            cnt += n;
+        /* Sum up blocks in 32 bits, 4096 * 4 cannot overflow. */
+        k = size < 4096 ? size : 4096;
+        bl = be = 0;
+        for ( i = 0; i + 256 <= k; i += 256 )
+            utf8_elen( s + i, 256, &bl, &be );
+        utf8_elen( s + i, k - i, &bl, &be );
+        len += bl;
+        bad += be;
+        s += k;
+        size -= k;
     }
     if ( NULL != errcnt )
         *errcnt = bad;
-    return ok;
+    return len;
 }
 
 
@@ -244,4 +394,118 @@ size_t utf8_stream_encode( uint32_t(*get)(void*), int(*put)(uint8_t*,int,void*),
 }
 
 
+/*
+ **** utf8_enc_update 3
+ **
+ ** NAME
+ **   utf8_enc_init, utf8_enc_update, utf8_enc_final - buffered UTF-32 to UTF-8 encoder
+ **
+ ** SYNOPSIS
+ **   #include <utf8_encode.h>
+ **
+ **   void utf8_enc_init(utf8_enc_ctx_t *ctx, uint8_t *buf, size_t size, int (*flush)(const uint8_t*,size_t,void*), void *usr);
+ **
+ **   size_t utf8_enc_update(utf8_enc_ctx_t *ctx, const uint32_t *s, size_t size);
+ **
+ **   size_t utf8_enc_final(utf8_enc_ctx_t *ctx, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   These functions perform the same conversion as utf8_stream_encode(3),
+ **   but take arrays of code points as input and collect the output in a
+ **   caller supplied block, which is handed to a call-back function only
+ **   when it is full. This saves an indirect call per character when
+ **   writing to e.g. a file or a socket.
+ **
+ **   The utf8_enc_init() function initializes the encoder context pointed
+ **   to by ctx to use the size bytes pointed to by buf as output block.
+ **   The size should be at least 4, to hold an encoding of any length.
+ **   The call-back function pointed to by flush is passed the block, the
+ **   number of bytes stored therein, and the user supplied pointer usr.
+ **   It shall return a value greater than or equal to zero upon success,
+ **   or a negative value to signal an error condition.
+ **
+ **   The utf8_enc_update() function encodes size code points from the
+ **   array s. For each invalid code point the replacement character U+FFFD
+ **   is produced. Sequences are never split across blocks.
+ **
+ **   The utf8_enc_final() function flushes any output still pending in
+ **   the block. If errcnt is not NULL, the total number of invalid code
+ **   points is stored in *errcnt. Afterwards the context is ready to be
+ **   reused for a new conversion with the same block and call-back.
+ **
+ **   Once the flush call-back failed, all further input is discarded
+ **   until utf8_enc_final() is called.
+ **
+ ** RETURN VALUE
+ **   The utf8_enc_update() function returns the number of code points
+ **   taken from s, which is less than size only if the flush call-back
+ **   failed.
+ **
+ **   The utf8_enc_final() function returns the total number of valid
+ **   code points encoded, or (size_t)-1, if the flush call-back failed.
+ **
+ ** NOTES
+ **   The context does not have to be initialized by utf8_enc_init(),
+ **   if it was statically initialized with UTF8_ENC_CTX_INITIALIZER and
+ **   has its buf, size and flush members set before use.
+ **
+ ** SEE ALSO
+ **   utf8_encode_h(3), utf8_stream_encode(3), utf8_dec_update(3)
+ **
+ */
+
+void utf8_enc_init( utf8_enc_ctx_t *ctx, uint8_t *buf, size_t size, int(*flush)(const uint8_t*,size_t,void*), void *usr )
+{
+    ctx->buf = buf;
+    ctx->size = size;
+    ctx->len = 0;
+    ctx->flush = flush;
+    ctx->usr = usr;
+    ctx->ok = 0;
+    ctx->err = 0;
+    ctx->fail = 0;
+}
+
+size_t utf8_enc_update( utf8_enc_ctx_t *ctx, const uint32_t *s, size_t size )
+{
+    size_t n, used, ok, bad, done = 0;
+
+    while ( done < size && !ctx->fail )
+    {
+        n = utf8_enc_fill( ctx->buf + ctx->len, ctx->size - ctx->len,
+                           s + done, size - done, &used, &ok, &bad );
+        ctx->len += n;
+        ctx->ok += ok;
+        ctx->err += bad;
+        done += used;
+        if ( done < size )
+        {
+            /* Block full, or too small to make any progress. */
+            if ( 0 == ctx->len || 0 > ctx->flush( ctx->buf, ctx->len, ctx->usr ) )
+                ctx->fail = 1;
+            ctx->len = 0;
+        }
+    }
+    return done;
+}
+
+size_t utf8_enc_final( utf8_enc_ctx_t *ctx, size_t *errcnt )
+{
+    size_t ok = ctx->ok;
+
+    if ( !ctx->fail && 0 < ctx->len
+         && 0 > ctx->flush( ctx->buf, ctx->len, ctx->usr ) )
+        ctx->fail = 1;
+    if ( ctx->fail )
+        ok = (size_t)-1;
+    if ( NULL != errcnt )
+        *errcnt = ctx->err;
+    ctx->len = 0;
+    ctx->ok = 0;
+    ctx->err = 0;
+    ctx->fail = 0;
+    return ok;
+}
+
+
 /* EOF */
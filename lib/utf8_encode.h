@@ -43,12 +43,25 @@
  **
  ** DESCRIPTION
  **
+ **   TYPES
+ **     utf8_enc_ctx_t  structure type to hold the state of a buffered encoder
+ **
  **   MACROS
  **     UTF_REPLACE_CHAR  Unicode code point used as replacement char
  **
+ **     UTF8_ENC_CTX_INITIALIZER  evaluates to an expression suitable to initialize static objects of type utf8_enc_ctx_t
+ **
  **   FUNCTIONS
+ **     utf8_str_encode()  encode UTF-32 string to UTF-8
+ **     utf8_mem_encode()  encode UTF-32 array to UTF-8
+ **
+ **     utf8_str_encoded_len()  length of UTF-8 encoding of UTF-32 string
+ **     utf8_mem_encoded_len()  length of UTF-8 encoding of UTF-32 array
+ **
  **     utf8_stream_encode()  call-back driven UTF-32 to UTF-8 encoder
  **
+ **     utf8_enc_init(), utf8_enc_update(), utf8_enc_final()  buffered UTF-32 to UTF-8 encoder
+ **
  ** SEE ALSO
  **   locale(1), locale(7)
  **
@@ -69,8 +82,35 @@ extern "C" {
 #define UTF_REPLACE_CHAR    0xFFFD
 
 
+extern size_t utf8_str_encode( uint8_t *buf, size_t max, const uint32_t *s, size_t *errcnt );
+extern size_t utf8_mem_encode( uint8_t *buf, size_t max, const uint32_t *s, size_t size, size_t *errcnt );
+
+extern size_t utf8_str_encoded_len( const uint32_t *s, size_t *errcnt );
+extern size_t utf8_mem_encoded_len( const uint32_t *s, size_t size, size_t *errcnt );
+
 extern size_t utf8_stream_encode( uint32_t(*get)(void*), int(*put)(uint8_t*,int,void*), void *usr, size_t *errcnt );
 
+#define UTF8_ENC_CTX_INITIALIZER  { NULL, 0, 0, NULL, NULL, 0, 0, 0 }
+
+struct utf8_enc_ctx_t_struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    int (*flush)(const uint8_t*,size_t,void*);
+    void *usr;
+    size_t ok;
+    size_t err;
+    int fail;
+};
+
+typedef
+    struct utf8_enc_ctx_t_struct
+    utf8_enc_ctx_t;
+
+extern void utf8_enc_init( utf8_enc_ctx_t *ctx, uint8_t *buf, size_t size, int(*flush)(const uint8_t*,size_t,void*), void *usr );
+extern size_t utf8_enc_update( utf8_enc_ctx_t *ctx, const uint32_t *s, size_t size );
+extern size_t utf8_enc_final( utf8_enc_ctx_t *ctx, size_t *errcnt );
+
 
 #ifdef __cplusplus
 } /* extern "C" { */
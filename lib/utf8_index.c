@@ -0,0 +1,239 @@
+/*
+ * utf8_index.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include <stddef.h>
+
+#include <utf8_index.h>
+
+#include "inc_priv/swar.h"
+#include "inc_priv/utf8_indec.h"
+#include "inc_priv/utf8_valid.h"
+
+
+/* Store the offset of code point number idx->next. When the storage is
+   exhausted, every other offset is dropped and the sampling interval
+   doubled, which may or may not render the current offset superfluous. */
+static void idx_put( utf8_index_t *idx, size_t off )
+{
+    size_t i;
+
+    if ( idx->n == idx->cap )
+    {
+        if ( 0 == idx->cap )
+        {
+            idx->next = (size_t)-1;
+            return;
+        }
+        for ( i = 0; i < idx->cap / 2; ++i )
+            idx->ofs[i] = idx->ofs[2 * i + 1];
+        idx->n = idx->cap / 2;
+        idx->k *= 2;
+        if ( ( idx->n + 1 ) * idx->k != idx->next )
+        {
+            idx->next = ( idx->n + 1 ) * idx->k;
+            return;
+        }
+    }
+    idx->ofs[idx->n++] = off;
+    idx->next += idx->k;
+}
+
+/* Skip m code points, starting at a sequence boundary at p. Malformed
+   sequences count as one code point each, as they decode to a single
+   replacement character. */
+static const unsigned char *idx_skip( const unsigned char *p, const unsigned char *end, size_t m )
+{
+    size_t n;
+    uint32_t cp;
+    int st;
+
+    while ( m > 0 && p < end )
+    {
+        if ( *p < 0x80 )
+        {
+            while ( m >= SWAR_SZ && end - p >= SWAR_SZ && !swar_hashigh( swar_ld( p ) ) )
+                m -= SWAR_SZ, p += SWAR_SZ;
+            if ( 0 == m || p == end )
+                break;
+        }
+        n = *p < 0x80 ? 1 : utf8_seq_decode( p, end - p, &cp );
+        if ( 0 == n )
+        {
+            st = UTF8_ACCEPT;
+            do
+                st = utf8_v( *p++, st );
+            while ( UTF8_ACCEPT != st && UTF8_REJECT != st && p < end );
+        }
+        else
+            p += n;
+        --m;
+    }
+    return p;
+}
+
+
+/*
+ **** utf8_index_build 3
+ **
+ ** NAME
+ **   utf8_index_build, utf8_index_append, utf8_index_seek - random access to UTF-8 text
+ **
+ ** SYNOPSIS
+ **   #include <utf8_index.h>
+ **
+ **   size_t utf8_index_build(utf8_index_t *idx, size_t *ofs, size_t cap, size_t k, const void *s, size_t len);
+ **   size_t utf8_index_append(utf8_index_t *idx, const void *s, size_t len);
+ **   size_t utf8_index_seek(const utf8_index_t *idx, const void *s, size_t n);
+ **
+ ** DESCRIPTION
+ **   These functions maintain a sampled index of the code point positions
+ **   in UTF-8 text, to locate the n-th code point without scanning the
+ **   text from the start. The index does not keep a reference to the
+ **   text, which is passed to each call instead and may be relocated
+ **   in between.
+ **
+ **   The utf8_index_build() function initializes the index object pointed
+ **   to by idx and indexes the first len bytes of the text pointed to by
+ **   s, storing the byte offset of every k-th code point in the array ofs
+ **   of cap elements. Should the array fill up, every other offset is
+ **   discarded and the sampling interval k doubled, so the index never
+ **   needs more than the memory supplied by the caller, at the expense of
+ **   longer seek times. A k of 0 is treated like 1.
+ **
+ **   The utf8_index_append() function extends the index, after text was
+ **   appended. The text pointed to by s of length len must start with
+ **   the text that was indexed before. A sequence left incomplete at the
+ **   end of the previously indexed text is correctly continued.
+ **
+ **   The utf8_index_seek() function returns the byte offset of code point
+ **   number n, counting from 0, in the indexed text pointed to by s. It
+ **   scans less than k code points from the nearest preceding sample.
+ **
+ **   Malformed sequences count as a single code point each, as they are
+ **   decoded to one replacement character by utf8_mem_decode(3), and so
+ **   does an incomplete sequence at the end of the text.
+ **
+ ** RETURN VALUE
+ **   The utf8_index_build() and utf8_index_append() functions return
+ **   the number of code points in the indexed text.
+ **
+ **   The utf8_index_seek() function returns the byte offset of the n-th
+ **   code point, or the length of the indexed text, if n equals the number
+ **   of code points. If n is greater than that, (size_t)-1 is returned.
+ **
+ ** NOTES
+ **   The ofs array is only accessed through idx and must remain valid
+ **   for the lifetime of the index.
+ **
+ ** SEE ALSO
+ **   utf8_mem_count(3), utf8_mem_decode(3)
+ **
+ */
+
+size_t utf8_index_build( utf8_index_t *idx, size_t *ofs, size_t cap, size_t k, const void *s, size_t len )
+{
+    idx->ofs = ofs;
+    idx->cap = NULL != ofs ? cap : 0;
+    idx->n = 0;
+    idx->k = 0 != k ? k : 1;
+    idx->next = idx->k;
+    idx->cnt = 0;
+    idx->len = 0;
+    idx->st = UTF8_ACCEPT;
+    return utf8_index_append( idx, s, len );
+}
+
+size_t utf8_index_append( utf8_index_t *idx, const void *s, size_t len )
+{
+    const unsigned char *b = s;
+    const unsigned char *p = b + idx->len;
+    const unsigned char *end = b + len;
+    size_t cnt = idx->cnt, n;
+    uint32_t cp;
+    int st = idx->st;
+
+    while ( p < end )
+    {
+        if ( UTF8_ACCEPT == st )
+        {
+            if ( *p < 0x80 )
+            {
+                /* Sample ASCII words by position. */
+                while ( end - p >= SWAR_SZ && !swar_hashigh( swar_ld( p ) ) )
+                {
+                    while ( idx->next - cnt < SWAR_SZ )
+                        idx_put( idx, p - b + ( idx->next - cnt ) );
+                    cnt += SWAR_SZ, p += SWAR_SZ;
+                }
+                if ( p == end )
+                    break;
+            }
+            if ( cnt == idx->next )
+                idx_put( idx, p - b );
+            n = *p < 0x80 ? 1 : utf8_seq_decode( p, end - p, &cp );
+            if ( 0 != n )
+            {
+                ++cnt;
+                p += n;
+                continue;
+            }
+        }
+        st = utf8_v( *p, st );
+        if ( UTF8_ACCEPT == st || UTF8_REJECT == st )
+            ++cnt, st = UTF8_ACCEPT;
+        ++p;
+    }
+    idx->cnt = cnt;
+    idx->len = len;
+    idx->st = st;
+    return cnt + ( UTF8_ACCEPT != st );
+}
+
+size_t utf8_index_seek( const utf8_index_t *idx, const void *s, size_t n )
+{
+    const unsigned char *b = s;
+    size_t i;
+
+    if ( n > idx->cnt + ( UTF8_ACCEPT != idx->st ) )
+        return (size_t)-1;
+    i = n / idx->k;
+    if ( i > idx->n )
+        i = idx->n;
+    if ( 0 != i )
+        b += idx->ofs[i - 1];
+    return idx_skip( b, (const unsigned char *)s + idx->len, n - i * idx->k )
+           - (const unsigned char *)s;
+}
+
+/* EOF */
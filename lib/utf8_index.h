@@ -0,0 +1,95 @@
+/*
+ * utf8_index.h
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ **** utf8_index_h 3
+ **
+ ** NAME
+ **   utf8_index - code point offset index for UTF-8 text
+ **
+ ** SYNOPSIS
+ **   #include <utf8_index.h>
+ **
+ ** DESCRIPTION
+ **
+ **   TYPES
+ **     utf8_index_t  structure type to hold a sampled code point index
+ **
+ **   FUNCTIONS
+ **     utf8_index_build()   index UTF-8 text
+ **     utf8_index_append()  extend an index over text appended to
+ **     utf8_index_seek()    find the byte offset of a code point
+ **
+ ** SEE ALSO
+ **   utf8_decode_h(3)
+ **
+ */
+
+#ifndef UTF8_INDEX_H_INLCLUDED
+#define UTF8_INDEX_H_INLCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+
+struct utf8_index_t_struct {
+    size_t *ofs;    /* byte offsets of code points k, 2k, 3k, ... */
+    size_t cap;     /* capacity of ofs */
+    size_t n;       /* number of offsets stored */
+    size_t k;       /* sampling interval */
+    size_t next;    /* number of the next code point to sample */
+    size_t cnt;     /* number of code points indexed */
+    size_t len;     /* number of bytes indexed */
+    int st;         /* decoder state at end of indexed text */
+};
+
+typedef
+    struct utf8_index_t_struct
+    utf8_index_t;
+
+extern size_t utf8_index_build( utf8_index_t *idx, size_t *ofs, size_t cap, size_t k, const void *s, size_t len );
+extern size_t utf8_index_append( utf8_index_t *idx, const void *s, size_t len );
+extern size_t utf8_index_seek( const utf8_index_t *idx, const void *s, size_t n );
+
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif  /* ndef UTF8_INDEX_H_INLCLUDED */
+
+/* EOF */
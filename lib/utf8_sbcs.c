@@ -0,0 +1,346 @@
+/*
+ * utf8_sbcs.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <utf8_sbcs.h>
+
+#include "inc_priv/swar.h"
+#include "inc_priv/utf8_indec.h"
+#include "inc_priv/utf8_inenc.h"
+#include "inc_priv/utf8_valid.h"
+
+#define UTF_REPLACE_CHAR    0xFFFD
+
+/* Windows-1252 code points for bytes 0x80 to 0x9F, 0 if undefined. */
+static const uint16_t cp1252_hi[32] = {
+    0x20AC, 0,      0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0,      0x017D, 0,
+    0,      0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0,      0x017E, 0x0178,
+};
+
+/* Copy ASCII runs word by word, as far as they fit. Output is only ever
+   stored in whole characters, see utf16.c. */
+static inline const unsigned char *ascii_run( unsigned char *buf, size_t *n, size_t lim,
+                                              const unsigned char *p, const unsigned char *end )
+{
+    size_t i;
+
+    while ( end - p >= SWAR_SZ && !swar_hashigh( swar_ld( p ) ) )
+    {
+        if ( *n + SWAR_SZ <= lim )
+            memcpy( buf + *n, p, SWAR_SZ );
+        else
+            for ( i = 0; i < SWAR_SZ && *n + i < lim; ++i )
+                buf[*n + i] = p[i];
+        *n += SWAR_SZ;
+        p += SWAR_SZ;
+    }
+    return p;
+}
+
+/* Transcode to UTF-8, with the Windows-1252 table, if hi is not NULL. */
+static size_t sb_to_u8( unsigned char *buf, size_t sz, const unsigned char *p, size_t len,
+                        size_t *errcnt, const uint16_t *hi )
+{
+    const unsigned char *end = p + len;
+    size_t n = 0, lim = sz, bad = 0;
+    uint32_t cp;
+    uint8_t b[4];
+    int k;
+
+    while ( p < end )
+    {
+        if ( *p < 0x80 )
+        {
+            p = ascii_run( buf, &n, lim, p, end );
+            for ( ; p < end && *p < 0x80; ++p, ++n )
+                if ( n < lim )
+                    buf[n] = *p;
+            continue;
+        }
+        cp = *p++;
+        if ( NULL != hi && cp < 0xA0 && 0 == ( cp = hi[cp - 0x80] ) )
+        {
+            cp = UTF_REPLACE_CHAR;
+            ++bad;
+        }
+        if ( cp < 0x800 && n + 2 <= lim )
+        {
+            buf[n++] = 0xC0 | cp >> 6;
+            buf[n++] = 0x80 | ( cp & 0x3F );
+            continue;
+        }
+        if ( n + 4 <= lim )
+            k = utf8_ec( cp, buf + n );
+        else
+        {
+            k = utf8_ec( cp, b );
+            if ( n + k > lim )
+            {
+                /* Lower the limit only once, it must not exceed sz. */
+                if ( n < lim )
+                    lim = n;
+            }
+            else
+                memcpy( buf + n, b, k );
+        }
+        n += k;
+    }
+    if ( NULL != errcnt )
+        *errcnt = bad;
+    return n;
+}
+
+/* Map a code point to ISO-8859-1, or to Windows-1252 if cp1252 is set.
+   Returns -1, if the code point is not representable. */
+static inline int sb_enc( uint32_t cp, int cp1252 )
+{
+    int i;
+
+    if ( !cp1252 )
+        return cp <= 0xFF ? (int)cp : -1;
+    if ( cp < 0x80 || cp - 0xA0 < 0x60 )
+        return cp;
+    for ( i = 0; i < 32; ++i )
+        if ( cp == cp1252_hi[i] && 0 != cp )
+            return 0x80 + i;
+    return -1;
+}
+
+/* Transcode from UTF-8, to Windows-1252 if cp1252 is set. */
+static size_t u8_to_sb( unsigned char *buf, size_t sz, const unsigned char *p, size_t len,
+                        size_t *errcnt, int cp1252 )
+{
+    const unsigned char *end = p + len;
+    int st = UTF8_ACCEPT;
+    size_t n = 0, bad = 0, k;
+    int c;
+    uint32_t cp = 0;
+
+    while ( p < end )
+    {
+        if ( UTF8_ACCEPT == st && *p < 0x80 )
+        {
+            p = ascii_run( buf, &n, sz, p, end );
+            for ( ; p < end && *p < 0x80; ++p, ++n )
+                if ( n < sz )
+                    buf[n] = *p;
+            continue;
+        }
+        if ( UTF8_ACCEPT == st && 0 != ( k = utf8_seq_decode( p, end - p, &cp ) ) )
+            p += k;
+        else
+        {
+            st = utf8_c( *p++, st, &cp );
+            if ( UTF8_REJECT == st )
+            {
+                /* Not representable, hence replaced below. */
+                st = UTF8_ACCEPT;
+                cp = UTF_REPLACE_CHAR;
+            }
+            else if ( UTF8_ACCEPT != st )
+                continue;
+        }
+        c = sb_enc( cp, cp1252 );
+        cp = 0;
+        if ( 0 > c )
+        {
+            c = SBCS_REPLACE_CHAR;
+            ++bad;
+        }
+        if ( n < sz )
+            buf[n] = c;
+        ++n;
+    }
+    if ( UTF8_ACCEPT != st )
+    {
+        if ( n < sz )
+            buf[n] = SBCS_REPLACE_CHAR;
+        ++n;
+        ++bad;
+    }
+    if ( NULL != errcnt )
+        *errcnt = bad;
+    return n;
+}
+
+
+/*
+ **** latin1_to_utf8 3
+ **
+ ** NAME
+ **   latin1_to_utf8, cp1252_to_utf8, latin1_utf8_len, cp1252_utf8_len - transcode single byte character sets to UTF-8
+ **
+ ** SYNOPSIS
+ **   #include <utf8_sbcs.h>
+ **
+ **   size_t latin1_to_utf8(void *buf, size_t sz, const void *s, size_t len);
+ **   size_t cp1252_to_utf8(void *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **
+ **   size_t latin1_utf8_len(const void *s, size_t len);
+ **   size_t cp1252_utf8_len(const void *s, size_t len);
+ **
+ ** DESCRIPTION
+ **   The latin1_to_utf8() function transcodes len bytes of ISO-8859-1
+ **   encoded text from the array s to UTF-8 and stores at most sz bytes
+ **   in buf, which is not null terminated. The output is truncated at a
+ **   character boundary, if buf is too small. Null bytes in s are not
+ **   treated special.
+ **
+ **   The cp1252_to_utf8() function is similar, but transcodes Windows-1252
+ **   encoded text. For each of the five bytes undefined in Windows-1252
+ **   the replacement character U+FFFD is produced. If errcnt is not NULL,
+ **   the number of replacements is stored in *errcnt.
+ **
+ **   The latin1_utf8_len() and cp1252_utf8_len() functions compute the
+ **   exact number of bytes the UTF-8 encoding of len bytes of ISO-8859-1
+ **   or Windows-1252 encoded text from the array s will occupy, without
+ **   actually performing the conversion.
+ **
+ ** RETURN VALUE
+ **   All functions return the total number of bytes required to store
+ **   the complete output. If the return value of latin1_to_utf8() or
+ **   cp1252_to_utf8() is greater than sz, the output was truncated.
+ **
+ ** NOTES
+ **   The objects pointed to by buf and s, respectively, shall not
+ **   overlap.
+ **
+ ** SEE ALSO
+ **   utf8_sbcs_h(3), utf8_to_latin1(3), utf8_mem_encode(3)
+ **
+ */
+
+size_t latin1_to_utf8( void *buf, size_t sz, const void *s, size_t len )
+{
+    return sb_to_u8( buf, sz, s, len, NULL, NULL );
+}
+
+size_t cp1252_to_utf8( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return sb_to_u8( buf, sz, s, len, errcnt, cp1252_hi );
+}
+
+size_t latin1_utf8_len( const void *s, size_t len )
+{
+    const unsigned char *p = s;
+    size_t n = len, i = 0;
+
+    /* Every byte with the high bit set takes one extra byte. */
+    for ( ; i + SWAR_SZ <= len; i += SWAR_SZ )
+        n += swar_cnt( swar_hashigh( swar_ld( p + i ) ) );
+    for ( ; i < len; ++i )
+        n += p[i] >> 7;
+    return n;
+}
+
+size_t cp1252_utf8_len( const void *s, size_t len )
+{
+    const unsigned char *p = s;
+    size_t n = latin1_utf8_len( s, len ), i = 0;
+    uint32_t cp;
+
+    /* Add one for each byte in the 0x80 to 0x9F range, that maps to a
+       three byte sequence. */
+    for ( ; i < len; ++i )
+    {
+        if ( i + SWAR_SZ <= len && !swar_hashigh( swar_ld( p + i ) ) )
+        {
+            i += SWAR_SZ - 1;
+            continue;
+        }
+        if ( p[i] >= 0x80 && p[i] < 0xA0 )
+        {
+            cp = cp1252_hi[p[i] - 0x80];
+            n += utf8_ev( 0 != cp ? cp : UTF_REPLACE_CHAR ) - 2;
+        }
+    }
+    return n;
+}
+
+
+/*
+ **** utf8_to_latin1 3
+ **
+ ** NAME
+ **   utf8_to_latin1, utf8_to_cp1252 - transcode UTF-8 to single byte character sets
+ **
+ ** SYNOPSIS
+ **   #include <utf8_sbcs.h>
+ **
+ **   size_t utf8_to_latin1(void *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **   size_t utf8_to_cp1252(void *buf, size_t sz, const void *s, size_t len, size_t *errcnt);
+ **
+ ** DESCRIPTION
+ **   The utf8_to_latin1() and utf8_to_cp1252() functions transcode len
+ **   bytes of UTF-8 encoded text from the array s to ISO-8859-1 and
+ **   Windows-1252, respectively, and store at most sz bytes in buf, which
+ **   is not null terminated. Null bytes in s are not treated special.
+ **
+ **   Each code point that is not representable in the target character
+ **   set, and each malformed sequence, including an incomplete sequence
+ **   at the end of input, is replaced with SBCS_REPLACE_CHAR ('?'). If
+ **   errcnt is not NULL, the number of replacements is stored in *errcnt.
+ **
+ ** RETURN VALUE
+ **   The utf8_to_latin1() and utf8_to_cp1252() functions return the total
+ **   number of bytes required to store the complete output, i.e. the
+ **   number of characters. If the return value is greater than sz, the
+ **   output was truncated.
+ **
+ ** NOTES
+ **   The objects pointed to by buf and s, respectively, shall not
+ **   overlap.
+ **
+ ** SEE ALSO
+ **   utf8_sbcs_h(3), latin1_to_utf8(3), utf8_mem_decode(3)
+ **
+ */
+
+size_t utf8_to_latin1( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return u8_to_sb( buf, sz, s, len, errcnt, 0 );
+}
+
+size_t utf8_to_cp1252( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt )
+{
+    return u8_to_sb( buf, sz, s, len, errcnt, 1 );
+}
+
+/* EOF */
@@ -0,0 +1,91 @@
+/*
+ * utf8_sbcs.h
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+/*
+ **** utf8_sbcs_h 3
+ **
+ ** NAME
+ **   utf8_sbcs - UTF-8 to and from single byte character set transcoding
+ **
+ ** SYNOPSIS
+ **   #include <utf8_sbcs.h>
+ **
+ ** DESCRIPTION
+ **
+ **   MACROS
+ **     SBCS_REPLACE_CHAR  character used as replacement for unrepresentable code points
+ **
+ **   FUNCTIONS
+ **     latin1_to_utf8(), cp1252_to_utf8()  transcode ISO-8859-1 and Windows-1252 to UTF-8
+ **
+ **     latin1_utf8_len(), cp1252_utf8_len()  compute the length of the UTF-8 output
+ **
+ **     utf8_to_latin1(), utf8_to_cp1252()  transcode UTF-8 to ISO-8859-1 and Windows-1252
+ **
+ ** SEE ALSO
+ **   utf8_decode_h(3), utf8_encode_h(3)
+ **
+ */
+
+#ifndef UTF8_SBCS_H_INCLUDED
+#define UTF8_SBCS_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+
+#undef SBCS_REPLACE_CHAR
+#define SBCS_REPLACE_CHAR   '?'
+
+
+extern size_t latin1_to_utf8( void *buf, size_t sz, const void *s, size_t len );
+extern size_t cp1252_to_utf8( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+
+extern size_t latin1_utf8_len( const void *s, size_t len );
+extern size_t cp1252_utf8_len( const void *s, size_t len );
+
+extern size_t utf8_to_latin1( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+extern size_t utf8_to_cp1252( void *buf, size_t sz, const void *s, size_t len, size_t *errcnt );
+
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif  /* ndef UTF8_SBCS_H_INCLUDED */
+
+/* EOF */
@@ -49,7 +49,7 @@ REGISTER( logging_test )
 {
     int err = 0;
     FILE *fp;
-    char buf[500];
+    char buf[LOG_ASYNC_MSGSZ];
 
     errno = 0;
     log_printf( LOG_DEBUG, "log_%s %m\n", "default" );
@@ -78,6 +78,91 @@ REGISTER( logging_test )
     log_xprintf( LOG_DEBUG, "%m\n" );
 #line 80 "extra/logging_test.c"
 
+    /* Asynchronous mode, with a queue short enough to overflow. */
+    for ( int policy = LOG_ASYNC_BLOCK; policy <= LOG_ASYNC_DROP; ++policy )
+    {
+        int i, n = 0, bol = 1, hit = 0;
+
+        while ( NULL == ( fp = tmpfile() ) )
+            ;
+        log_async_config( 4, policy );
+        log_open( LOG_DEBUG, LOG_TO_FILE | LOG_ASYNC, fp, "log_async", 0, 0 );
+        for ( i = 0; i < 100; ++i )
+            log_printf( LOG_INFO, "async %d\n", i );
+        log_printf( LOG_INFO, "%0*d\n", 2 * LOG_ASYNC_MSGSZ, 0 );
+        log_close();
+        rewind( fp );
+        /* Count whole lines, fgets() may split long ones. */
+        while ( NULL != fgets( buf, sizeof buf, fp ) )
+        {
+            if ( bol )
+                hit = NULL != strstr( buf, "log_async[" );
+            bol = NULL != strchr( buf, '\n' );
+            if ( bol && hit )
+                ++n;
+        }
+        if ( LOG_ASYNC_BLOCK == policy ? n != 101 : n < 1 || n > 101 )
+            ++err;
+        fclose( fp );
+    }
+    log_async_config( LOG_ASYNC_QLEN, LOG_ASYNC_BLOCK );
+
+    /* Deferred formatting must yield the same text as immediate one. */
+    {
+        static const char *const fmt = "%d|%-*s|%.2f|%5.3s|%zu|%Lg|%c%%m|%m\n";
+        const char *p;
+        char exp[LOG_ASYNC_MSGSZ];
+
+        errno = EINVAL;
+        snprintf( exp, sizeof exp, "%d|%-*s|%.2f|%5.3s|%zu|%Lg|%c%%m|%s\n",
+                  -42, 6, "ab", 3.14159, "xyz_", (size_t)7, 1.5L, 'c', strerror( EINVAL ) );
+        while ( NULL == ( fp = tmpfile() ) )
+            ;
+        log_open( LOG_DEBUG, LOG_TO_FILE | LOG_DEFER, fp, "log_defer", 0, 0 );
+        errno = EINVAL;
+        log_printf( LOG_INFO, fmt, -42, 6, "ab", 3.14159, "xyz_", (size_t)7, 1.5L, 'c' );
+        log_close();
+        rewind( fp );
+        if ( NULL == fgets( buf, sizeof buf, fp )
+             || NULL == ( p = strstr( buf, "log_defer[" ) )
+             || NULL == ( p = strstr( p, ":6: " ) )
+             || 0 != strcmp( p + 4, exp ) )
+            ++err;
+        fclose( fp );
+
+        /* String arguments exceeding the record are not cut. */
+        char s1[121], s2[121], s3[121];
+        memset( s1, 'a', 120 );
+        memset( s2, 'b', 120 );
+        memset( s3, 'c', 120 );
+        s1[120] = s2[120] = s3[120] = '\0';
+        snprintf( exp, sizeof exp, "%s|%s|%s|%d\n", s1, s2, s3, 42 );
+        while ( NULL == ( fp = tmpfile() ) )
+            ;
+        log_open( LOG_DEBUG, LOG_TO_FILE | LOG_DEFER, fp, "log_defer", 0, 0 );
+        log_printf( LOG_INFO, "%s|%s|%s|%d\n", s1, s2, s3, 42 );
+        log_close();
+        rewind( fp );
+        if ( NULL == fgets( buf, sizeof buf, fp )
+             || NULL == ( p = strstr( buf, "log_defer[" ) )
+             || NULL == ( p = strstr( p, ":6: " ) )
+             || 0 != strcmp( p + 4, exp ) )
+            ++err;
+        fclose( fp );
+    }
+
+    /* Level checks. */
+    log_open( LOG_INFO, LOG_TO_FILE, stderr, "log_to_stderr", 0, 0 );
+    if ( log_enabled( LOG_DEBUG ) || !log_enabled( LOG_INFO ) )
+        ++err;
+    log_open( LOG_DEBUG, 0, stderr, "log_to_nowhere", 0, 0 );
+    if ( log_enabled( LOG_EMERG ) )
+        ++err;
+    log_close();
+    if ( !log_enabled( LOG_DEBUG ) )
+        ++err;
+    log_open( LOG_DEBUG, LOG_TO_FILE, stderr, "log_to_stderr", 0, 0 );
+
     if ( !err )
         PASS( "logging ok" );
     else
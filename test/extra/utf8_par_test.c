@@ -0,0 +1,94 @@
+/*
+ * utf8_par_test.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <utf8_decode.h>
+#include <utf8_par.h>
+
+#include "../testsupp.h"
+
+
+REGISTER( utf8_par_test )
+{
+    static const char *tok[] = {
+        "A", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80",
+        "\x80", "\xE2\x82", "\xF0\x9F\x98", "\xED\xA0\x80", "\xFF",
+    };
+    const size_t size = 8 * UTF8_PAR_MIN_CHUNK + 5;
+    unsigned char *buf;
+    size_t n, l, e1, e2, o1, o2;
+    unsigned r = 1;
+    int i, t;
+
+    if ( NULL == ( buf = malloc( size ) ) )
+    {
+        FAIL( "malloc" );
+        return 1;
+    }
+    for ( n = 0; n < size; n += l )
+    {
+        r = r * 1103515245u + 12345u;
+        /* Mostly well formed text, with an occasional malformed token. */
+        i = ( r >> 16 ) % 64;
+        i = i < 60 ? i % 4 : 4 + i % 5;
+        l = strlen( tok[i] );
+        if ( l > size - n )
+            l = size - n;
+        memcpy( buf + n, tok[i], l );
+    }
+    /* Plant truncated sequences right at some chunk boundaries. */
+    memcpy( buf + size / 2 - 1, "\xE2", 1 );
+    memcpy( buf + size / 3 - 2, "\xF0\x9F", 2 );
+    memcpy( buf + size / 7 - 1, "\xF0\x9F\x98\x80", 4 );
+
+    o1 = utf8_mem_count( buf, size, &e1 );
+    for ( t = 0; t <= 9; ++t )
+    {
+        o2 = utf8_mem_count_par( buf, size, &e2, t );
+        if ( o1 != o2 || e1 != e2 )
+        {
+            FAIL( "utf8_mem_count_par, %d threads: %zu/%zu, expected %zu/%zu",
+                  t, o2, e2, o1, e1 );
+            free( buf );
+            return 1;
+        }
+    }
+    free( buf );
+    PASS( "utf8_mem_count_par" );
+    return 0;
+}
+
+/* EOF */
@@ -144,6 +144,12 @@ REGISTER( str_escape_test2 )
         { "\\101", 1, 0,   4, 0 },
         { " %",    2, 0,   1, 1 },
         { "%1",    2, 0,   0, 1 },
+        { "\\q",   1, 1,   2, 0 },
+        { "\\12",  1, 0,   3, 0 },
+        { "\\1234", 2, 0,  5, 0 },
+        { "\\x41g", 2, 0,  5, 0 },
+        { "%41%",  4, 0,   1, 1 },
+        { "%4g",   3, 0,   1, 1 },
         { NULL,    0, 0,   0, 0 }
     };
     int n_exp = 0, e_exp = 0, gd = 0, bd = 0;
@@ -178,4 +184,212 @@ REGISTER( str_escape_test2 )
 }
 
 
+REGISTER( str_escape_test3 )
+{
+    int i, err = 0;
+    size_t n, e;
+    char buf[500];
+
+    static const struct {
+        const char *s;
+        const char *json;
+        size_t e_json;  /* (size_t)-1: no validation */
+    } str_json[] = {
+        { "", "", 0 },
+        { "plain ASCII text, long enough to take the fast path", "plain ASCII text, long enough to take the fast path", 0 },
+        { "say \"hi\"\\o/", "say \\\"hi\\\"\\\\o/", 0 },
+        { "\b\f\n\r\t\a\x1f\x7f", "\\b\\f\\n\\r\\t\\u0007\\u001F\x7f", 0 },
+        { "0123456789abcdef\n0123456789abcdef", "0123456789abcdef\\n0123456789abcdef", 0 },
+        { "ÄÖÜäöü€", "ÄÖÜäöü€", 0 },
+        { "bad \xC3\x28 utf-8", "bad \\ufffd utf-8", 1 },
+        { "bad \xC3\x28 utf-8", "bad \xC3\x28 utf-8", (size_t)-1 },
+        { "dangling \xE2\x82", "dangling \\ufffd", 1 },
+        { "\xff\xfe\"", "\\ufffd\\ufffd\\\"", 2 },
+        { NULL, NULL, 0 }
+    };
+
+    for ( i = 0; str_json[i].s; ++i )
+    {
+        if ( (size_t)-1 == str_json[i].e_json )
+            e = (size_t)-1, n = str_jsonescape( buf, sizeof buf, str_json[i].s, NULL );
+        else
+            n = str_jsonescape( buf, sizeof buf, str_json[i].s, &e );
+        if ( n >= sizeof buf || e != str_json[i].e_json || strcmp( buf, str_json[i].json ) )
+        {
+            ++err;
+            FAIL( "str_jsonescape failed on index %d", i );
+        }
+        /* Truncated output must be a prefix of the full result. */
+        n = str_jsonescape( buf, 12, str_json[i].s, NULL );
+        if ( strlen( buf ) > 11 || ( n < 12 && strlen( buf ) != n ) )
+        {
+            ++err;
+            FAIL( "str_jsonescape truncation failed on index %d", i );
+        }
+    }
+    n = str_escape( buf, 12, "0123456789abcdefghij" );
+    if ( 20 != n || strcmp( buf, "0123456789a" ) )
+    {
+        ++err;
+        FAIL( "str_escape truncation failed" );
+    }
+    if ( !err )
+        PASS( "str_jsonescape test3 %d/%d", i, i );
+    return err;
+}
+
+/* Push s through a stream coder in chunks of ilen input bytes, using an
+   output buffer of olen bytes, collect the results in buf. */
+static size_t stream_esc( char *buf, const char *s, size_t ilen, size_t olen, int url )
+{
+    char ob[16];
+    size_t n = 0, len = strlen( s ), c, k;
+
+    while ( len )
+    {
+        k = url ? str_urlencode_update( ob, olen, s, len < ilen ? len : ilen, &c )
+                : str_escape_update( ob, olen, s, len < ilen ? len : ilen, &c );
+        memcpy( buf + n, ob, k );
+        n += k;
+        s += c;
+        len -= c;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+static size_t stream_unesc( char *buf, const char *s, size_t ilen, size_t olen, int url, size_t *e )
+{
+    char ob[16];
+    size_t n = 0, len = strlen( s ), c, k;
+    str_unesc_ctx_t ctx = STR_UNESC_CTX_INITIALIZER;
+
+    while ( len )
+    {
+        k = url ? str_urldecode_update( &ctx, ob, olen, s, len < ilen ? len : ilen, &c )
+                : str_unescape_update( &ctx, ob, olen, s, len < ilen ? len : ilen, &c );
+        memcpy( buf + n, ob, k );
+        n += k;
+        s += c;
+        len -= c;
+    }
+    n += url ? str_urldecode_final( &ctx, buf + n, 1, e )
+             : str_unescape_final( &ctx, buf + n, 1, e );
+    buf[n] = '\0';
+    return n;
+}
+
+REGISTER( str_escape_test4 )
+{
+    int i, url, err = 0;
+    size_t n, m, e, f, il, ol;
+    char buf[500], ref[500];
+    static const char *tst[] = {
+        "",
+        "plain and simple, but long enough for the fast path",
+        "\a\b\f\n\r\t\v\\\"'?",
+        "ÄÖÜäöü€ 100%",
+        "\\x41\\x4g\\101\\1\\18\\q\\",
+        "%41%4g%%2",
+        "\\x",
+        "%",
+        NULL
+    };
+
+    for ( i = 0; tst[i]; ++i )
+    {
+        for ( url = 0; url < 2; ++url )
+        {
+            for ( il = 1; il < 10; il += 4 )
+            {
+                for ( ol = 4; ol < 16; ol += 5 )
+                {
+                    n = url ? str_urlencode( ref, sizeof ref, tst[i] )
+                            : str_escape( ref, sizeof ref, tst[i] );
+                    m = stream_esc( buf, tst[i], il, ol, url );
+                    if ( n != m || strcmp( buf, ref ) )
+                    {
+                        ++err;
+                        FAIL( "stream escaping failed on index %d/%d/%zu/%zu", i, url, il, ol );
+                    }
+                    n = url ? str_urldecode( ref, sizeof ref, tst[i], &e )
+                            : str_unescape( ref, sizeof ref, tst[i], &e );
+                    m = stream_unesc( buf, tst[i], il, ol - 3, url, &f );
+                    if ( n != m || e != f || memcmp( buf, ref, n ) )
+                    {
+                        ++err;
+                        FAIL( "stream unescaping failed on index %d/%d/%zu/%zu", i, url, il, ol );
+                    }
+                }
+            }
+        }
+    }
+    if ( !err )
+        PASS( "str_escape_update/str_unescape_update test4 %d/%d", i, i );
+    return err;
+}
+
+REGISTER( str_escape_test5 )
+{
+    int err = 0;
+    size_t n, e;
+    char buf[500];
+
+    n = mem_escape( buf, sizeof buf, "a\0b\"", 4 );
+    if ( 6 != n || strcmp( buf, "a\\0b\\\"" ) )
+    {
+        ++err;
+        FAIL( "mem_escape failed" );
+    }
+    n = mem_unescape( buf, sizeof buf, buf, n, &e );
+    if ( 4 != n || e || memcmp( buf, "a\0b\"", 5 ) )
+    {
+        ++err;
+        FAIL( "mem_unescape failed" );
+    }
+    n = mem_urlencode( buf, sizeof buf, "Unreserved-Characters_0123456789.~\0/Reserved:/?#", 48 );
+    if ( 60 != n || strcmp( buf, "Unreserved-Characters_0123456789.~%00%2FReserved%3A%2F%3F%23" ) )
+    {
+        ++err;
+        FAIL( "mem_urlencode failed" );
+    }
+    n = mem_urldecode( buf, sizeof buf, buf, n, &e );
+    if ( 48 != n || e || memcmp( buf, "Unreserved-Characters_0123456789.~\0/Reserved:/?#", 49 ) )
+    {
+        ++err;
+        FAIL( "mem_urldecode failed" );
+    }
+    n = mem_jsonescape( buf, sizeof buf, "\0\xC3\xA4", 3, &e );
+    if ( 8 != n || e || strcmp( buf, "\\u0000\xC3\xA4" ) )
+    {
+        ++err;
+        FAIL( "mem_jsonescape failed" );
+    }
+    /* In-place conversion, with and without truncation. */
+    strcpy( buf, "clean%20string" );
+    n = mem_urldecode( buf, sizeof buf, buf, 14, &e );
+    if ( 12 != n || e || strcmp( buf, "clean string" ) )
+    {
+        ++err;
+        FAIL( "mem_urldecode in-place failed" );
+    }
+    strcpy( buf, "abcd\\tef" );
+    n = mem_unescape( buf, 3, buf, 8, &e );
+    if ( 7 != n || e || strcmp( buf, "ab" ) )
+    {
+        ++err;
+        FAIL( "mem_unescape in-place truncation failed" );
+    }
+    /* Input length limits must be honored. */
+    n = mem_urlencode( buf, sizeof buf, "abc def", 3 );
+    if ( 3 != n || strcmp( buf, "abc" ) )
+    {
+        ++err;
+        FAIL( "mem_urlencode length limit failed" );
+    }
+    if ( !err )
+        PASS( "mem_escape/mem_unescape test5" );
+    return err;
+}
+
 /* EOF */
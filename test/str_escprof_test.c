@@ -0,0 +1,158 @@
+/*
+ * str_escprof_test.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include "testsupp.h"
+
+#include <string.h>
+
+#include <str_escprof.h>
+
+static const str_escrule_t html[] = {
+    { '&',  '&',  ESCPROF_SYM, "&amp;" },
+    { '<',  '<',  ESCPROF_SYM, "&lt;" },
+    { '>',  '>',  ESCPROF_SYM, "&gt;" },
+    { '"',  '"',  ESCPROF_SYM, "&quot;" },
+    { '\'', '\'', ESCPROF_SYM, "&#39;" },
+};
+
+static const str_escrule_t form[] = {
+    { 0x00, 0xff, ESCPROF_PCT, NULL },
+    { '0',  '9',  ESCPROF_LIT, NULL },
+    { 'A',  'Z',  ESCPROF_LIT, NULL },
+    { 'a',  'z',  ESCPROF_LIT, NULL },
+    { '-',  '.',  ESCPROF_LIT, NULL },
+    { '_',  '_',  ESCPROF_LIT, NULL },
+    { '*',  '*',  ESCPROF_LIT, NULL },
+    { ' ',  ' ',  ESCPROF_SYM, "+" },
+};
+
+static const str_escrule_t csv[] = {
+    { '"',  '"',  ESCPROF_SYM, "\"\"" },
+};
+
+static const str_escrule_t shell[] = {
+    { '\'', '\'', ESCPROF_SYM, "'\\''" },
+};
+
+static const str_escrule_t cstr[] = {
+    { 0x00, 0x1f, ESCPROF_OCT, NULL },
+    { 0x7f, 0xff, ESCPROF_HEX, NULL },
+    { '\\', '\\', ESCPROF_SYM, "\\\\" },
+    { '\n', '\n', ESCPROF_SYM, "\\n" },
+};
+
+#define RULES(R)    R, sizeof R / sizeof *R
+
+REGISTER( str_escprof_test )
+{
+    int i, err = 0;
+    size_t n, e;
+    char buf[500];
+    str_escprof_t prof;
+    static const struct {
+        const str_escrule_t *rules;
+        size_t nrules;
+        const char *org;
+        const char *esc;
+    } tst[] = {
+        { RULES(html),  "", "" },
+        { RULES(html),  "<a href=\"x\">Tom & Jerry's</a>",
+                        "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&#39;s&lt;/a&gt;" },
+        { RULES(form),  "a b+c=d&e~€", "a+b%2Bc%3Dd%26e%7E%E2%82%AC" },
+        { RULES(csv),   "say \"hi\"", "say \"\"hi\"\"" },
+        { RULES(shell), "it's", "it'\\''s" },
+        { RULES(cstr),  "a\tb\\\n\x7f\xff", "a\\011b\\\\\\n\\x7F\\xFF" },
+        { NULL, 0, NULL, NULL }
+    };
+
+    for ( i = 0; tst[i].rules; ++i )
+    {
+        if ( 0 != str_escprof_init( &prof, tst[i].rules, tst[i].nrules ) )
+        {
+            ++err;
+            FAIL( "str_escprof_init failed on index %d", i );
+            continue;
+        }
+        n = str_escprof_encode( &prof, buf, sizeof buf, tst[i].org, strlen( tst[i].org ) );
+        if ( n >= sizeof buf || n != strlen( buf ) || strcmp( buf, tst[i].esc ) )
+        {
+            ++err;
+            FAIL( "str_escprof_encode failed on index %d", i );
+        }
+        n = str_escprof_decode( &prof, buf, sizeof buf, buf, strlen( buf ), &e );
+        if ( n >= sizeof buf || e || strcmp( buf, tst[i].org ) )
+        {
+            ++err;
+            FAIL( "str_escprof_decode failed on index %d", i );
+        }
+        /* Truncated output must be a prefix of the full result. */
+        n = str_escprof_encode( &prof, buf, 8, tst[i].org, strlen( tst[i].org ) );
+        if ( strncmp( buf, tst[i].esc, strlen( buf ) ) || strlen( buf ) > 7 )
+        {
+            ++err;
+            FAIL( "str_escprof_encode truncation failed on index %d", i );
+        }
+    }
+
+    /* Invalid escape sequences. */
+    str_escprof_init( &prof, RULES(form) );
+    n = str_escprof_decode( &prof, buf, sizeof buf, "a%2 %zz+=", 9, &e );
+    if ( 9 != n || 2 != e || strcmp( buf, "a%2 %zz =" ) )
+    {
+        ++err;
+        FAIL( "str_escprof_decode error detection failed" );
+    }
+
+    /* Invalid rules. */
+    static const str_escrule_t bad[] = {
+        { 'z',  'a',  ESCPROF_LIT, NULL },
+        { 'a',  'a',  ESCPROF_SYM, "" },
+        { 'a',  'a',  ESCPROF_SYM, "&toolong;" },
+        { 'a',  'a',  42, NULL },
+    };
+    for ( i = 0; i < (int)(sizeof bad / sizeof *bad); ++i )
+    {
+        if ( -1 != str_escprof_init( &prof, bad + i, 1 ) )
+        {
+            ++err;
+            FAIL( "str_escprof_init accepted invalid rule %d", i );
+        }
+    }
+
+    if ( !err )
+        PASS( "str_escprof_test ok" );
+    return err;
+}
+
+/* EOF */
@@ -0,0 +1,99 @@
+/*
+ * str_form_test.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include <string.h>
+
+#include <str_form.h>
+
+#include "testsupp.h"
+
+
+REGISTER( str_form_test )
+{
+    int i, err = 0;
+    size_t len, e, etot = 0;
+    char buf[200];
+    char *s, *orig;
+    str_form_kv_t kv;
+    static const char *form =
+        "q=caf%C3%A9+au+lait&lang=fr&&flag&=empty&plain=a+b%2Bc&bad=%zz%4&x=y=z&";
+    static const struct {
+        const char *k;
+        const char *v;
+    } exp[] = {
+        { "q",      "caf\xC3\xA9 au lait" },
+        { "lang",   "fr" },
+        { "flag",   "" },
+        { "",       "empty" },
+        { "plain",  "a b+c" },
+        { "bad",    "zz" },
+        { "x",      "y=z" },
+    };
+
+    strcpy( buf, form );
+    s = buf;
+    len = strlen( buf );
+    for ( i = 0; str_form_next( &s, &len, &kv, &e ); ++i )
+    {
+        etot += e;
+        if ( i >= (int)( sizeof exp / sizeof *exp )
+             || kv.klen != strlen( exp[i].k ) || memcmp( kv.key, exp[i].k, kv.klen )
+             || kv.vlen != strlen( exp[i].v ) || memcmp( kv.val, exp[i].v, kv.vlen ) )
+        {
+            ++err;
+            FAIL( "str_form_next failed on index %d", i );
+        }
+    }
+    if ( i != (int)( sizeof exp / sizeof *exp ) || 0 != len || 2 != etot )
+    {
+        ++err;
+        FAIL( "str_form_next: %d fields, %d errors", i, (int)etot );
+    }
+    /* Fields without '+' or '%' must be left untouched. */
+    strcpy( buf, "a=1&b=2" );
+    s = orig = buf;
+    len = strlen( buf );
+    if ( !str_form_next( &s, &len, &kv, NULL ) || kv.key != orig || kv.val != orig + 2
+         || !str_form_next( &s, &len, &kv, NULL ) || kv.key != orig + 4 || kv.val != orig + 6
+         || str_form_next( &s, &len, &kv, NULL ) || strcmp( buf, "a=1&b=2" ) )
+    {
+        ++err;
+        FAIL( "str_form_next zero-copy check failed" );
+    }
+    if ( !err )
+        PASS( "str_form_test %d/%d", i, i );
+    return err;
+}
+
+/* EOF */
@@ -0,0 +1,103 @@
+/*
+ * utf16_test.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <utf16.h>
+
+#include "testsupp.h"
+
+
+/* "Aé€😀" plus a malformed byte, in UTF-8 and UTF-16LE. */
+static const char u8[] = "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xFF";
+static const char u16le[] = "A\0\xE9\0\xAC\x20\x3D\xD8\x00\xDE\xFD\xFF";
+
+
+REGISTER( utf16_test )
+{
+    char buf[32], *hb;
+    size_t e, n, i;
+
+    n = utf8_to_utf16le( buf, sizeof buf, u8, sizeof u8 - 1, &e );
+    if ( sizeof u16le - 1 != n || 1 != e || memcmp( buf, u16le, n ) )
+    {
+        FAIL( "utf8_to_utf16le: %zu bytes, %zu errors", n, e );
+        return 1;
+    }
+    n = utf8_to_utf16be( buf, sizeof buf, u8, sizeof u8 - 1, &e );
+    for ( i = 0; i < n; ++i )
+        if ( buf[i] != u16le[i ^ 1] )
+            break;
+    if ( sizeof u16le - 1 != n || 1 != e || i != n )
+    {
+        FAIL( "utf8_to_utf16be: %zu bytes, %zu errors", n, e );
+        return 1;
+    }
+    /* Back, with a lone low surrogate and an odd trailing byte added. */
+    memcpy( buf, u16le, sizeof u16le - 1 );
+    memcpy( buf + sizeof u16le - 1, "\x00\xDC\x41", 3 );
+    n = utf16le_to_utf8( buf + 16, 16, buf, sizeof u16le + 2, &e );
+    if ( 19 != n || 2 != e || memcmp( buf + 16, u8, 10 )
+         || memcmp( buf + 16 + 10, "\xEF\xBF\xBD", 3 ) )
+    {
+        FAIL( "utf16le_to_utf8: %zu bytes, %zu errors", n, e );
+        return 1;
+    }
+    /* Truncation happens at code point boundaries only. */
+    memset( buf, 0, sizeof buf );
+    n = utf8_to_utf16le( buf, 8, u8, sizeof u8 - 1, &e );
+    if ( 12 != n || memcmp( buf, u16le, 6 ) || buf[6] || buf[7] )
+    {
+        FAIL( "utf8_to_utf16le truncation: %zu bytes", n );
+        return 1;
+    }
+    /* Truncated big endian output must stay within an exactly sized
+       buffer, on the heap to allow checking with a memory debugger. */
+    if ( NULL != ( hb = malloc( 4 ) ) )
+    {
+        n = utf8_to_utf16be( hb, 4, "abcdef", 6, &e );
+        i = 12 != n || memcmp( hb, "\0a\0b", 4 );
+        free( hb );
+        if ( i )
+        {
+            FAIL( "utf8_to_utf16be truncation: %zu bytes", n );
+            return 1;
+        }
+    }
+    PASS( "utf8_to_utf16le/be, utf16le_to_utf8" );
+    return 0;
+}
+
+/* EOF */
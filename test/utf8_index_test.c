@@ -0,0 +1,86 @@
+/*
+ * utf8_index_test.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include <string.h>
+
+#include <utf8_index.h>
+
+#include "testsupp.h"
+
+
+REGISTER( utf8_index_test )
+{
+    /* "Aé€😀" plus a malformed byte, repeated; 5 code points per copy. */
+    static const char u8[] = "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xFF";
+    static const size_t pos[] = { 0, 1, 3, 6, 10 };
+    char buf[40 * ( sizeof u8 - 1 )];
+    size_t ofs[4];
+    utf8_index_t idx;
+    size_t i, n, l = sizeof u8 - 1;
+
+    for ( i = 0; i < 40; ++i )
+        memcpy( buf + i * l, u8, l );
+    /* Index half of it, with a truncated sequence at the end. */
+    n = utf8_index_build( &idx, ofs, 4, 3, buf, 20 * l + 8 );
+    if ( 20 * 5 + 4 != n || 20 * l + 6 != utf8_index_seek( &idx, buf, n - 1 ) )
+    {
+        FAIL( "utf8_index_build: %zu code points", n );
+        return 1;
+    }
+    /* Continue, which completes the sequence and exhausts the storage. */
+    n = utf8_index_append( &idx, buf, sizeof buf );
+    if ( 40 * 5 != n || idx.k <= 3 )
+    {
+        FAIL( "utf8_index_append: %zu code points, k=%zu", n, idx.k );
+        return 1;
+    }
+    for ( i = 0; i < n; ++i )
+    {
+        if ( utf8_index_seek( &idx, buf, i ) != i / 5 * l + pos[i % 5] )
+        {
+            FAIL( "utf8_index_seek(%zu)", i );
+            return 1;
+        }
+    }
+    if ( sizeof buf != utf8_index_seek( &idx, buf, n )
+         || (size_t)-1 != utf8_index_seek( &idx, buf, n + 1 ) )
+    {
+        FAIL( "utf8_index_seek() past end" );
+        return 1;
+    }
+    PASS( "utf8_index" );
+    return 0;
+}
+
+/* EOF */
@@ -0,0 +1,110 @@
+/*
+ * utf8_sbcs_test.c
+ *
+ * Copyright 2017 Urban Wallasch <irrwahn35@freenet.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <utf8_sbcs.h>
+
+#include "testsupp.h"
+
+
+REGISTER( utf8_sbcs_test )
+{
+    static const char l1[] = "caf\xE9 \x80\x81\xFF";
+    static const char l1u8[] = "caf\xC3\xA9 \xC2\x80\xC2\x81\xC3\xBF";
+    static const char cpu8[] = "caf\xC3\xA9 \xE2\x82\xAC\xEF\xBF\xBD\xC3\xBF";
+    char buf[32], *hb;
+    size_t e, n;
+
+    n = latin1_to_utf8( buf, sizeof buf, l1, sizeof l1 - 1 );
+    if ( sizeof l1u8 - 1 != n || memcmp( buf, l1u8, n )
+         || n != latin1_utf8_len( l1, sizeof l1 - 1 ) )
+    {
+        FAIL( "latin1_to_utf8: %zu bytes", n );
+        return 1;
+    }
+    n = cp1252_to_utf8( buf, sizeof buf, l1, sizeof l1 - 1, &e );
+    if ( sizeof cpu8 - 1 != n || 1 != e || memcmp( buf, cpu8, n )
+         || n != cp1252_utf8_len( l1, sizeof l1 - 1 ) )
+    {
+        FAIL( "cp1252_to_utf8: %zu bytes, %zu errors", n, e );
+        return 1;
+    }
+    /* Truncation happens at character boundaries only. */
+    memset( buf, 0, sizeof buf );
+    n = cp1252_to_utf8( buf, 7, l1, sizeof l1 - 1, &e );
+    if ( sizeof cpu8 - 1 != n || memcmp( buf, cpu8, 6 ) || buf[6] )
+    {
+        FAIL( "cp1252_to_utf8 truncation: %zu bytes", n );
+        return 1;
+    }
+    /* Output truncated after a three byte sequence, followed by more
+       multibyte sequences and ASCII, must stay within an exactly sized
+       buffer, on the heap to allow checking with a memory debugger. */
+    if ( NULL != ( hb = malloc( 6 ) ) )
+    {
+        n = cp1252_to_utf8( hb, 6, "ab\x80\x80\xE9" "cdefghijklmnop", 19, &e );
+        e = 24 != n || memcmp( hb, "ab\xE2\x82\xAC", 5 );
+        free( hb );
+        if ( e )
+        {
+            FAIL( "cp1252_to_utf8 truncation: %zu bytes", n );
+            return 1;
+        }
+    }
+    n = utf8_to_latin1( buf, sizeof buf, l1u8, sizeof l1u8 - 1, &e );
+    if ( sizeof l1 - 1 != n || 0 != e || memcmp( buf, l1, n ) )
+    {
+        FAIL( "utf8_to_latin1: %zu bytes, %zu errors", n, e );
+        return 1;
+    }
+    /* U+0081 and U+FFFD are not representable in Windows-1252. */
+    n = utf8_to_cp1252( buf, sizeof buf, cpu8, sizeof cpu8 - 1, &e );
+    if ( 8 != n || 1 != e || memcmp( buf, "caf\xE9 \x80?\xFF", n ) )
+    {
+        FAIL( "utf8_to_cp1252: %zu bytes, %zu errors", n, e );
+        return 1;
+    }
+    n = utf8_to_cp1252( buf, sizeof buf, l1u8, sizeof l1u8 - 1, &e );
+    if ( 8 != n || 2 != e || memcmp( buf, "caf\xE9 ??\xFF", n ) )
+    {
+        FAIL( "utf8_to_cp1252: %zu bytes, %zu errors", n, e );
+        return 1;
+    }
+    PASS( "latin1/cp1252 to and from UTF-8" );
+    return 0;
+}
+
+/* EOF */
@@ -32,6 +32,7 @@
  *
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "testsupp.h"
@@ -54,6 +55,11 @@ static const struct {
     { "\xEF\xBF\xBD", 1, 0 },           /* replacement character U+FFFD */
     { "\xEF\xBF\xBE", 1, 0 },           /* noncharacter U+FFFE */
     { "\xEF\xBF\xBF", 1, 0 },           /* noncharacter U+FFFF */
+    { "\xED\xA0\x80", 0, 2 },           /* encoded surrogate U+D800 */
+    { "\xE2\x82", 0, 1 },               /* truncated sequence */
+    { "\xe0\x9f\xbf\xc2\xa9\xf4\x8f\xbf\xbf", 2, 2 }, /* range boundaries */
+    { "0123456789abcdef\xE2\x82\xAC" "0123456789\x80"
+      "abcdef\xf4\x90\x80\x80xyz", 36, 4 }, /* long ASCII runs */
     { "", 0, 0 },                       /* empty string */
     { NULL, 0, 0 }
 };
@@ -90,6 +96,14 @@ REGISTER( utf8_dectest )
         eg += dectst[i].good;
         b += e;
         eb += dectst[i].bad;
+
+        n = utf8_mem_count_trusted( dectst[i].s, strlen(dectst[i].s) );
+        if ( 0 == dectst[i].bad && n != dectst[i].good )
+        {
+            ++r;
+            FAIL( "utf8_mem_count_trusted: i=%d %zu/%zu good",
+                        i, n, dectst[i].good );
+        }
     }
     if ( !r )
         PASS( "utf8_str_count, utf8_mem_count: %zu/%zu good, %zu/%zu expected bad",
@@ -97,6 +111,99 @@ REGISTER( utf8_dectest )
     return r;
 }
 
+static const char dec_in[] = "0123456789abcdef\xE2\x82\xAC" "xyz\x80!";
+static const uint32_t dec_exp[] = {
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+        'a', 'b', 'c', 'd', 'e', 'f', 0x20AC, 'x', 'y', 'z',
+        UTF_REPLACE_CHAR, '!'
+};
+
+REGISTER( utf8_decodetest )
+{
+    uint32_t out[32];
+    size_t e, n, max;
+
+    for ( max = 0; max <= 22; max += 11 )
+    {
+        memset( out, 0, sizeof out );
+        n = utf8_mem_decode( out, max, (void *)dec_in, sizeof dec_in - 1, &e );
+        if ( 21 != n || 1 != e || 0 != memcmp( out, dec_exp, max * sizeof *out )
+             || 0 != out[max] )
+        {
+            FAIL( "utf8_mem_decode: max=%zu %zu/21 good, %zu/1 bad", max, n, e );
+            return 1;
+        }
+    }
+    PASS( "utf8_mem_decode: %zu good, %zu bad", n, e );
+    return 0;
+}
+
+REGISTER( utf8_dec_chunktest )
+{
+    utf8_dec_ctx_t ctx = UTF8_DEC_CTX_INITIALIZER;
+    uint32_t out[32];
+    size_t c, e, k, n = 0, pos = 0;
+
+    /* Split sequences across chunks, with output space for 2 at most. */
+    while ( pos < sizeof dec_in - 1 )
+    {
+        k = sizeof dec_in - 1 - pos;
+        if ( k > 3 )
+            k = 3;
+        n += utf8_dec_update( &ctx, out + n, 2, dec_in + pos, k, &c );
+        pos += c;
+    }
+    k = utf8_dec_final( &ctx, &e );
+    if ( 22 != n || 21 != k || 1 != e || 0 != memcmp( out, dec_exp, sizeof dec_exp ) )
+    {
+        FAIL( "utf8_dec_update: %zu/22 stored, %zu/21 good, %zu/1 bad", n, k, e );
+        return 1;
+    }
+    PASS( "utf8_dec_update: %zu good, %zu bad", k, e );
+    return 0;
+}
+
+REGISTER( utf8_sanitizetest )
+{
+    static const char exp[] = "0123456789abcdef\xE2\x82\xAC" "xyz\xEF\xBF\xBD!\xEF\xBF\xBD";
+    char in[sizeof dec_in + 1], buf[sizeof exp], *hb;
+    size_t e, n;
+
+    /* Append a truncated sequence. */
+    memcpy( in, dec_in, sizeof dec_in - 1 );
+    in[sizeof dec_in - 1] = '\xC3';
+    n = utf8_mem_sanitize( buf, sizeof buf, in, sizeof in, &e );
+    if ( sizeof exp - 1 != n || 2 != e || memcmp( buf, exp, n ) )
+    {
+        FAIL( "utf8_mem_sanitize: %zu bytes, %zu errors", n, e );
+        return 1;
+    }
+    /* Sequences are not truncated. */
+    memset( buf, 0, sizeof buf );
+    n = utf8_mem_sanitize( buf, 18, in, sizeof in, &e );
+    if ( sizeof exp - 1 != n || memcmp( buf, exp, 16 ) || buf[16] )
+    {
+        FAIL( "utf8_mem_sanitize: short buffer" );
+        return 1;
+    }
+    /* Output truncated inside a valid run, followed by replacements,
+       must stay within an exactly sized buffer, on the heap to allow
+       checking with a memory debugger. */
+    if ( NULL != ( hb = malloc( 18 ) ) )
+    {
+        n = utf8_mem_sanitize( hb, 18, in, sizeof in, &e );
+        e = sizeof exp - 1 != n || memcmp( hb, exp, 16 );
+        free( hb );
+        if ( e )
+        {
+            FAIL( "utf8_mem_sanitize truncation: %zu bytes", n );
+            return 1;
+        }
+    }
+    PASS( "utf8_mem_sanitize" );
+    return 0;
+}
+
 /*******************************************/
 
 #include <utf8_encode.h>
@@ -165,4 +272,116 @@ REGISTER( utf8_enctest )
     return 0;
 }
 
+/* Fill in with code points cycling through the table, skipping the
+   null word, and exp with their expected encoding. Returns the length
+   of the latter. */
+static size_t enc_input( uint32_t *in, size_t cnt, uint8_t *exp, size_t *good, size_t *bad )
+{
+    size_t i, j, k, l;
+
+    *good = *bad = 0;
+    for ( i = k = 0, j = 1; i < cnt; ++i )
+    {
+        if ( (uint32_t)EOF == enctst[j].u32 )
+            j = 1;
+        in[i] = enctst[j].u32;
+        if ( 0 < enctst[j].exp )
+        {
+            l = strlen( enctst[j].u8 );
+            memcpy( exp + k, enctst[j].u8, l );
+            ++*good;
+        }
+        else
+        {
+            l = 3;
+            memcpy( exp + k, "\xEF\xBF\xBD", l );
+            ++*bad;
+        }
+        k += l;
+        ++j;
+    }
+    return k;
+}
+
+REGISTER( utf8_encodetest )
+{
+    uint32_t in[64];
+    uint8_t exp[256], buf[256];
+    size_t e, i, k, l, n, good, bad;
+
+    /* Long enough to cover both the block-wise and the per code point
+       paths. */
+    k = enc_input( in, sizeof in / sizeof *in, exp, &good, &bad );
+    n = utf8_mem_encode( buf, sizeof buf, in, sizeof in / sizeof *in, &e );
+    if ( good != n || bad != e || memcmp( buf, exp, k ) )
+    {
+        FAIL( "utf8_mem_encode: %zu/%zu good, %zu/%zu bad", n, good, e, bad );
+        return 1;
+    }
+    l = utf8_mem_encoded_len( in, sizeof in / sizeof *in, &e );
+    if ( k != l || bad != e )
+    {
+        FAIL( "utf8_mem_encoded_len: %zu/%zu bytes, %zu/%zu bad", l, k, e, bad );
+        return 1;
+    }
+    /* Only whole sequences are stored in a short buffer. */
+    memset( buf, 0, sizeof buf );
+    utf8_mem_encode( buf, 42, in, sizeof in / sizeof *in, &e );
+    for ( i = 41; i > 0 && 0x80 == ( exp[i] & 0xc0 ); --i )
+        ;
+    if ( memcmp( buf, exp, i ) || buf[i] )
+    {
+        FAIL( "utf8_mem_encode: short buffer" );
+        return 1;
+    }
+    PASS( "utf8_mem_encode: %zu/%zu good, %zu/%zu expected bad", n, good, e, bad );
+    return 0;
+}
+
+struct encsink {
+    uint8_t buf[256];
+    size_t len;
+    size_t calls;
+};
+
+static int flush( const uint8_t *b, size_t n, void *usr )
+{
+    struct encsink *p = usr;
+
+    if ( p->len + n > sizeof p->buf )
+        return -1;
+    memcpy( p->buf + p->len, b, n );
+    p->len += n;
+    p->calls++;
+    return 0;
+}
+
+REGISTER( utf8_enc_chunktest )
+{
+    uint32_t in[64];
+    uint8_t exp[256], blk[16];
+    size_t e, i, k, n, good, bad;
+    struct encsink sink = { { 0 }, 0, 0 };
+    utf8_enc_ctx_t ctx;
+
+    k = enc_input( in, sizeof in / sizeof *in, exp, &good, &bad );
+    utf8_enc_init( &ctx, blk, sizeof blk, flush, &sink );
+    for ( i = 0; i < sizeof in / sizeof *in; i += n )
+    {
+        n = sizeof in / sizeof *in - i < 7 ? sizeof in / sizeof *in - i : 7;
+        if ( n != utf8_enc_update( &ctx, in + i, n ) )
+            break;
+    }
+    n = utf8_enc_final( &ctx, &e );
+    if ( good != n || bad != e || k != sink.len || memcmp( sink.buf, exp, k )
+         || sink.calls < k / sizeof blk )
+    {
+        FAIL( "utf8_enc_update: %zu/%zu good, %zu/%zu bad, %zu/%zu bytes",
+              n, good, e, bad, sink.len, k );
+        return 1;
+    }
+    PASS( "utf8_enc_update: %zu bytes in %zu blocks", sink.len, sink.calls );
+    return 0;
+}
+
 /* EOF */